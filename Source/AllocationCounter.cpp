@@ -0,0 +1,48 @@
+#include "AllocationCounter.h"
+
+#if AUDIOVISUALIZER_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+static thread_local juce::int64 threadAllocations = 0;
+
+static void* countedAllocate(std::size_t size) noexcept
+{
+    ++threadAllocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new (std::size_t size)
+{
+    if (auto* p = countedAllocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    if (auto* p = countedAllocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new   (std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+
+void operator delete   (void* p) noexcept                        { std::free(p); }
+void operator delete[] (void* p) noexcept                        { std::free(p); }
+void operator delete   (void* p, std::size_t) noexcept           { std::free(p); }
+void operator delete[] (void* p, std::size_t) noexcept           { std::free(p); }
+void operator delete   (void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+bool        AllocationCounter::isEnabled()      { return true; }
+juce::int64 AllocationCounter::getThreadCount() { return threadAllocations; }
+
+#else
+
+bool        AllocationCounter::isEnabled()      { return false; }
+juce::int64 AllocationCounter::getThreadCount() { return 0; }
+
+#endif
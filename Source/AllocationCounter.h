@@ -0,0 +1,36 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Debug aid for the frame path: counts the heap allocations the calling thread
+// makes through operator new (standard containers, juce::String, make_unique).
+// JUCE's own HeapBlock-backed containers call malloc directly and aren't seen.
+// Counting is compiled in only with AUDIOVISUALIZER_COUNT_ALLOCATIONS, which the
+// CMake build sets for Debug; it replaces the global operator new and delete.
+// (implementation in AllocationCounter.cpp)
+struct AllocationCounter
+{
+    static bool        isEnabled();
+    static juce::int64 getThreadCount();   // allocations made by this thread so far
+
+    // Asserts, when armed, that nothing in its scope allocated
+    class ExpectNone
+    {
+    public:
+        explicit ExpectNone(bool shouldCheck)
+            : armed(shouldCheck && isEnabled()), start(getThreadCount()) {}
+
+        ~ExpectNone()
+        {
+            // A frame whose inputs didn't change allocated: something on the render
+            // path grew or was rebuilt when it should have been reused
+            jassert(!armed || getThreadCount() == start);
+        }
+
+    private:
+        bool        armed;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ExpectNone)
+    };
+};
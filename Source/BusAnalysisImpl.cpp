@@ -0,0 +1,704 @@
+#include "PluginProcessor.h"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static constexpr float kMinFreq = 20.0f;      // descriptors ignore DC rumble below this
+static constexpr float kMaxFreq = 20000.0f;
+static constexpr float kRolloffFraction = 0.85f;
+
+static constexpr double kChromaMinFreq   = 100.0;   // below this bins smear across semitones anyway
+static constexpr double kChromaMaxFreq   = 5000.0;  // above this it's mostly overtones and noise
+static constexpr float  kChromaSmoothing = 0.8f;    // per hop, keeps the dominant class stable
+
+static constexpr double kPitchMinFreq      = 50.0;    // low male voice / bass lead
+static constexpr double kPitchMaxFreq      = 1500.0;  // top of a soprano, most lead synths
+static constexpr float  kPitchPeakFraction = 0.9f;    // MPM "k": first key maximum within 90% of the best
+static constexpr float  kPitchMinClarity   = 0.5f;    // below this the frame isn't considered pitched
+static constexpr int    kMaxKeyMaxima      = 32;
+
+static constexpr float  kStereoSmoothing   = 0.7f;    // per hop
+
+static constexpr double kMelMinFreq          = 40.0;
+static constexpr double kMelMaxFreq          = 8000.0;
+static constexpr double kFeatureFrameSeconds = 0.5;    // one self-similarity row per this much audio
+static constexpr float  kNoveltyThreshold    = 1.5f;   // standard deviations above the recent mean
+static constexpr float  kNoveltyFloor        = 0.1f;   // ignore peaks on a flat curve
+static constexpr int    kMinSectionFrames    = 16;     // ~8 s between reported sections
+
+// Replaces oldValue with newValue in a sorted window of n floats, keeping it sorted.
+// The binary search is O(log n); the slide only covers the distance between the
+// two values' ranks, so the window is never re-sorted.
+static void sortedReplace(float* window, int n, float oldValue, float newValue)
+{
+    int i = (int)(std::lower_bound(window, window + n, oldValue) - window);
+
+    if (newValue > oldValue)
+        while (i + 1 < n && window[i + 1] < newValue) { window[i] = window[i + 1]; ++i; }
+    else
+        while (i > 0 && window[i - 1] > newValue) { window[i] = window[i - 1]; --i; }
+
+    window[i] = newValue;
+}
+
+// Cheap log2 (~0.01 abs error) that keeps the descriptor loop free of libm calls
+static inline float fastLog2(float x)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float)((int)((bits >> 23) & 255u) - 128);
+    bits = (bits & ~(255u << 23)) | (127u << 23);   // mantissa in [1, 2)
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    return exponent + ((-1.0f / 3.0f) * m + 2.0f) * m - 2.0f / 3.0f;
+}
+
+// Maps 20 Hz .. 20 kHz onto 0..1 along a log axis (how brightness is perceived)
+static float normaliseLogFreq(float hz)
+{
+    if (hz <= kMinFreq) return 0.0f;
+    return juce::jlimit(0.0f, 1.0f, std::log2(hz / kMinFreq) / std::log2(kMaxFreq / kMinFreq));
+}
+
+// ---------------------------------------------------------------------------
+// Spectral descriptors
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::BusAnalysis::processMagnitudes(const float* magnitudes, float binWidth,
+                                                               const ChromaMap& chromaMap, const MelMap& melMap)
+{
+    processChroma(magnitudes, chromaMap);
+    processHarmonicPercussive(magnitudes, binWidth);
+    accumulateFeatures(magnitudes, melMap);
+
+    int firstBin = juce::jlimit(1, numBins, (int)(kMinFreq / binWidth));
+    int lastBin  = juce::jlimit(firstBin, numBins, (int)(kMaxFreq / binWidth));
+    int count    = lastBin - firstBin;
+
+    // One branch-free pass: weighted moments, log-sum for flatness, rectified flux
+    float sum = 0.0f, freqSum = 0.0f, freqSqSum = 0.0f, logSum = 0.0f, fluxSum = 0.0f;
+    for (int bin = firstBin; bin < lastBin; ++bin)
+    {
+        float m    = magnitudes[bin];
+        float freq = (float)bin * binWidth;
+        sum       += m;
+        freqSum   += m * freq;
+        freqSqSum += m * freq * freq;
+        logSum    += fastLog2(m + 1.0e-9f);
+        fluxSum   += std::max(0.0f, m - prevMagnitudes[(size_t)bin]);
+    }
+
+    std::copy(magnitudes, magnitudes + numBins, prevMagnitudes.begin());
+
+    // Flux is auto-gained like the bands so it reads the same on quiet and loud material
+    fluxSum /= (float)std::max(1, count);
+    fluxAverage = fluxAverage * averageSmoothingFactor + fluxSum * (1.0f - averageSmoothingFactor);
+    float fluxNorm = std::max(fluxAverage, minAverageThreshold);
+    flux.store(juce::jlimit(0.0f, 1.0f, (fluxSum / fluxNorm) * 0.5f));
+
+    if (count <= 0 || sum < 1.0e-6f)
+    {
+        // Silence: nothing to describe
+        centroid.store(0.0f);
+        spread.store(0.0f);
+        flatness.store(0.0f);
+        rolloff.store(0.0f);
+        return;
+    }
+
+    float centre   = freqSum / sum;
+    float variance = std::max(0.0f, freqSqSum / sum - centre * centre);
+    float geoMean  = std::exp2(logSum / (float)count);
+    float mean     = sum / (float)count;
+
+    // Roll-off: first bin where the running sum crosses 85% (early exit, usually short)
+    float target = sum * kRolloffFraction, cumulative = 0.0f;
+    int rolloffBin = lastBin - 1;
+    for (int bin = firstBin; bin < lastBin; ++bin)
+    {
+        cumulative += magnitudes[bin];
+        if (cumulative >= target)
+        {
+            rolloffBin = bin;
+            break;
+        }
+    }
+
+    centroid.store(normaliseLogFreq(centre));
+    spread.store(normaliseLogFreq(kMinFreq + std::sqrt(variance)));
+    flatness.store(juce::jlimit(0.0f, 1.0f, geoMean / mean));
+    rolloff.store(normaliseLogFreq((float)rolloffBin * binWidth));
+}
+
+// ---------------------------------------------------------------------------
+// Chroma
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::ChromaMap::prepare(double sampleRate)
+{
+    if (sampleRate <= 0.0 || (sampleRate == builtForRate && builtForSize == fftSize))
+        return;
+
+    builtForRate = sampleRate;
+    builtForSize = fftSize;
+    numEntries   = 0;
+
+    const double binWidth = sampleRate / fftSize;
+
+    // A bin wider than a semitone can't be assigned a pitch class, so start
+    // where the spectrum resolves individual notes
+    const double minFreq = std::max(kChromaMinFreq, binWidth / (std::pow(2.0, 1.0 / 12.0) - 1.0));
+
+    for (int bin = 1; bin < numBins; ++bin)
+    {
+        double freq = bin * binWidth;
+        if (freq < minFreq) continue;
+        if (freq > kChromaMaxFreq) break;
+
+        // Fractional MIDI pitch, split linearly between the two nearest semitones
+        double pitch = 69.0 + 12.0 * std::log2(freq / 440.0);
+        double lower = std::floor(pitch);
+        float  frac  = (float)(pitch - lower);
+        int    pc    = ((int)lower % numPitchClasses + numPitchClasses) % numPitchClasses;
+
+        entries[(size_t)numEntries++] = { bin, pc, 1.0f - frac };
+        entries[(size_t)numEntries++] = { bin, (pc + 1) % numPitchClasses, frac };
+    }
+}
+
+void AudioVisualizerProcessor::BusAnalysis::processChroma(const float* magnitudes,
+                                                           const ChromaMap& chromaMap)
+{
+    float raw[numPitchClasses] = {};
+    for (int i = 0; i < chromaMap.numEntries; ++i)
+    {
+        const auto& e = chromaMap.entries[(size_t)i];
+        raw[e.pitchClass] += e.weight * magnitudes[e.bin];
+    }
+
+    float peak = 0.0f, total = 0.0f;
+    int   dominant = -1;
+    for (int pc = 0; pc < numPitchClasses; ++pc)
+    {
+        auto& c = chromaSmooth[(size_t)pc];
+        c = c * kChromaSmoothing + raw[pc] * (1.0f - kChromaSmoothing);
+        total += c;
+        if (c > peak) { peak = c; dominant = pc; }
+    }
+
+    if (peak < 1.0e-6f)
+    {
+        for (auto& c : chroma) c.store(0.0f);
+        dominantPitchClass.store(-1);
+        pitchClassStrength.store(0.0f);
+        return;
+    }
+
+    for (int pc = 0; pc < numPitchClasses; ++pc)
+        chroma[(size_t)pc].store(chromaSmooth[(size_t)pc] / peak);
+
+    // 0 when every class is equal (noise, silence), 1 when a single class owns it all
+    float mean     = total / (float)numPitchClasses;
+    float strength = juce::jlimit(0.0f, 1.0f, (peak - mean) / (peak * (1.0f - 1.0f / numPitchClasses)));
+
+    dominantPitchClass.store(strength > 0.05f ? dominant : -1);
+    pitchClassStrength.store(strength);
+}
+
+// ---------------------------------------------------------------------------
+// Time-domain history + pitch (McLeod Pitch Method)
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::BusAnalysis::pushSamples(const juce::AudioBuffer<float>& bus,
+                                                         const juce::dsp::FFT& fft,
+                                                         const float* windowTable,
+                                                         double sampleRate)
+{
+    int numChannels = std::min(bus.getNumChannels(), 2);
+    if (numChannels == 0) return;
+
+    // Mono buses feed both sides (centred, fully correlated)
+    const float* left  = bus.getReadPointer(0);
+    const float* right = bus.getReadPointer(numChannels - 1);
+
+    for (int i = 0; i < bus.getNumSamples(); ++i)
+    {
+        leftHistory[(size_t)historyPos]  = left[i];
+        rightHistory[(size_t)historyPos] = right[i];
+        historyPos = (historyPos + 1) & (fftSize - 1);
+
+        if (++samplesSinceHop >= analysisHop)
+        {
+            samplesSinceHop = 0;
+            processPitch(fft, sampleRate);
+            processStereo(fft, windowTable, sampleRate);
+
+            int hopsPerFeature = std::max(1, (int)std::lround(kFeatureFrameSeconds * sampleRate / analysisHop));
+            if (++hopsSinceFeature >= hopsPerFeature)
+            {
+                hopsSinceFeature = 0;
+                processFeatureFrame();
+            }
+        }
+    }
+}
+
+void AudioVisualizerProcessor::BusAnalysis::processPitch(const juce::dsp::FFT& fft, double sampleRate)
+{
+    if (sampleRate <= 0.0) return;
+
+    // Latest pitchWindow samples, oldest first
+    float* x = pitchFrame.data();
+    float sumSq = 0.0f;
+    for (int i = 0; i < pitchWindow; ++i)
+    {
+        auto idx = (size_t)((historyPos - pitchWindow + i) & (fftSize - 1));
+        x[i] = 0.5f * (leftHistory[idx] + rightHistory[idx]);
+        sumSq += x[i] * x[i];
+    }
+
+    if (sumSq < 1.0e-6f)
+    {
+        pitchConfidence.store(0.0f);
+        return;
+    }
+
+    // Autocorrelation through the FFT: zero-pad to 2W, |X|^2, inverse
+    float* work = pitchScratch.data();
+    std::copy(x, x + pitchWindow, work);
+    std::fill(work + pitchWindow, work + fftSize * 2, 0.0f);
+
+    fft.performRealOnlyForwardTransform(work, true);
+    for (int k = 0; k <= fftSize / 2; ++k)
+    {
+        float re = work[2 * k], im = work[2 * k + 1];
+        work[2 * k]     = re * re + im * im;
+        work[2 * k + 1] = 0.0f;
+    }
+    fft.performRealOnlyInverseTransform(work);
+
+    // work[tau] is now r(tau); match it to the direct energy so the NSDF
+    // doesn't depend on the FFT backend's inverse scaling
+    if (work[0] <= 0.0f) return;
+    const float rScale = sumSq / work[0];
+
+    int tauMin = std::max(2, (int)(sampleRate / kPitchMaxFreq));
+    int tauMax = std::min(pitchWindow - 2, (int)(sampleRate / kPitchMinFreq));
+
+    // NSDF n(tau) = 2 r(tau) / m(tau), with m updated incrementally.
+    // Reuse the second half of the scratch buffer to hold it.
+    float* nsdf = work + fftSize;
+    float m = 2.0f * sumSq;
+    nsdf[0] = 1.0f;
+    for (int tau = 1; tau <= tauMax + 1; ++tau)
+    {
+        m -= x[tau - 1] * x[tau - 1] + x[pitchWindow - tau] * x[pitchWindow - tau];
+        nsdf[tau] = m > 1.0e-9f ? 2.0f * work[tau] * rScale / m : 0.0f;
+    }
+
+    // Key maxima: highest point of each positive lobe after the first negative crossing
+    int   keyTau[kMaxKeyMaxima];
+    float keyVal[kMaxKeyMaxima];
+    int   numKeys = 0;
+    float highest = 0.0f;
+    bool  pastFirstDip = false;
+    int   lobeTau = -1;
+    float lobeVal = 0.0f;
+
+    for (int tau = 1; tau <= tauMax && numKeys < kMaxKeyMaxima; ++tau)
+    {
+        float v = nsdf[tau];
+        if (!pastFirstDip)
+        {
+            pastFirstDip = v < 0.0f;
+            continue;
+        }
+
+        if (v > 0.0f)
+        {
+            if (tau >= tauMin && v > lobeVal) { lobeVal = v; lobeTau = tau; }
+        }
+        else if (lobeTau >= 0)
+        {
+            keyTau[numKeys] = lobeTau;
+            keyVal[numKeys] = lobeVal;
+            ++numKeys;
+            highest = std::max(highest, lobeVal);
+            lobeTau = -1;
+            lobeVal = 0.0f;
+        }
+    }
+    if (lobeTau >= 0 && numKeys < kMaxKeyMaxima)
+    {
+        keyTau[numKeys] = lobeTau;
+        keyVal[numKeys] = lobeVal;
+        ++numKeys;
+        highest = std::max(highest, lobeVal);
+    }
+
+    int chosen = -1;
+    for (int k = 0; k < numKeys; ++k)
+    {
+        if (keyVal[k] >= kPitchPeakFraction * highest)
+        {
+            chosen = k;
+            break;
+        }
+    }
+
+    if (chosen < 0 || keyVal[chosen] < kPitchMinClarity)
+    {
+        pitchConfidence.store(chosen < 0 ? 0.0f : keyVal[chosen]);
+        return;   // hold the last confident frequency
+    }
+
+    // Parabolic interpolation around the peak for sub-sample lag
+    int   tau = keyTau[chosen];
+    float a = nsdf[tau - 1], b = nsdf[tau], c = nsdf[tau + 1];
+    float denom = a - 2.0f * b + c;
+    float delta = std::abs(denom) > 1.0e-9f ? juce::jlimit(-0.5f, 0.5f, 0.5f * (a - c) / denom) : 0.0f;
+
+    pitchHz.store((float)(sampleRate / (tau + delta)));
+    pitchConfidence.store(juce::jlimit(0.0f, 1.0f, b));
+}
+
+// ---------------------------------------------------------------------------
+// Stereo field
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::BusAnalysis::processStereo(const juce::dsp::FFT& fft,
+                                                           const float* windowTable,
+                                                           double sampleRate)
+{
+    if (sampleRate <= 0.0) return;
+
+    // Pack both channels into one complex transform: z = L + iR
+    for (int n = 0; n < fftSize; ++n)
+    {
+        auto idx = (size_t)((historyPos + n) & (fftSize - 1));   // oldest first
+        stereoIn[(size_t)n] = { leftHistory[idx] * windowTable[n], rightHistory[idx] * windowTable[n] };
+    }
+
+    fft.perform(stereoIn.data(), stereoOut.data(), false);
+
+    // Unpack per bin: L[k] = (Z[k] + Z*[N-k]) / 2,  R[k] = (Z[k] - Z*[N-k]) / 2i
+    // and accumulate L/R/cross/mid/side energies for every band in one sweep
+    float sumLL[numBands] = {}, sumRR[numBands] = {}, sumLR[numBands] = {};
+    float sumMid[numBands] = {}, sumSide[numBands] = {};
+
+    const float binWidth = (float)(sampleRate / fftSize);
+    int bandStart[numBands], bandEnd[numBands];
+    for (int b = 0; b < numBands; ++b)
+    {
+        bandStart[b] = juce::jlimit(1, numBins, (int)(bandEdges[b][0] / binWidth));
+        bandEnd[b]   = juce::jlimit(1, numBins, (int)(bandEdges[b][1] / binWidth));
+    }
+
+    for (int k = 1; k < numBins; ++k)
+    {
+        auto z  = stereoOut[(size_t)k];
+        auto zc = std::conj(stereoOut[(size_t)(fftSize - k)]);
+
+        auto l = (z + zc) * 0.5f;
+        auto d = (z - zc) * 0.5f;
+        juce::dsp::Complex<float> r { d.imag(), -d.real() };   // d / i
+
+        float ll = std::norm(l), rr = std::norm(r);
+        float lr = l.real() * r.real() + l.imag() * r.imag();   // Re(L R*)
+        float mid  = 0.25f * (ll + rr + 2.0f * lr);              // |(L+R)/2|^2
+        float side = 0.25f * (ll + rr - 2.0f * lr);              // |(L-R)/2|^2
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            if (k < bandStart[b] || k >= bandEnd[b]) continue;
+            sumLL[b] += ll;  sumRR[b] += rr;  sumLR[b] += lr;
+            sumMid[b] += mid; sumSide[b] += side;
+        }
+    }
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        float energy = sumLL[b] + sumRR[b];
+        float corr = 1.0f, width = 0.0f, pan = 0.0f;   // silence reads as centred mono
+
+        if (energy > 1.0e-9f)
+        {
+            corr  = sumLR[b] / std::max(std::sqrt(sumLL[b] * sumRR[b]), 1.0e-12f);
+            width = sumSide[b] / std::max(sumMid[b] + sumSide[b], 1.0e-12f);
+            pan   = (sumRR[b] - sumLL[b]) / energy;
+        }
+
+        auto& sc = stereoSmooth[0][(size_t)b];
+        auto& sw = stereoSmooth[1][(size_t)b];
+        auto& sp = stereoSmooth[2][(size_t)b];
+        sc = sc * kStereoSmoothing + juce::jlimit(-1.0f, 1.0f, corr) * (1.0f - kStereoSmoothing);
+        sw = sw * kStereoSmoothing + juce::jlimit(0.0f, 1.0f, width) * (1.0f - kStereoSmoothing);
+        sp = sp * kStereoSmoothing + juce::jlimit(-1.0f, 1.0f, pan)  * (1.0f - kStereoSmoothing);
+
+        stereoCorrelation[(size_t)b].store(sc);
+        stereoWidth[(size_t)b].store(sw);
+        stereoPan[(size_t)b].store(sp);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Harmonic / percussive separation (median filtering, Fitzgerald-style)
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::BusAnalysis::processHarmonicPercussive(const float* magnitudes, float binWidth)
+{
+    constexpr int T = hpssTimeWindow;
+    constexpr int F = hpssFreqWindow;
+    constexpr int halfF = F / 2;
+
+    // Percussive estimate: median across frequency (broadband clicks survive,
+    // isolated partials don't). One sorted window slides along the bins.
+    auto magAt = [magnitudes](int bin) { return (bin >= 0 && bin < numBins) ? magnitudes[bin] : 0.0f; };
+
+    float window[F];
+    for (int j = 0; j < F; ++j)
+        window[j] = magAt(j - halfF);
+    std::sort(window, window + F);
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        percussiveMedian[(size_t)bin] = window[halfF];
+        sortedReplace(window, F, magAt(bin - halfF), magAt(bin + halfF + 1));
+    }
+
+    // Harmonic estimate: median across the last T hops per bin (sustained
+    // partials survive, hits don't). Each bin swaps its oldest value for the new one.
+    float harmonicSum[numBands] = {}, percussiveSum[numBands] = {};
+    int bandStart[numBands], bandEnd[numBands];
+    for (int b = 0; b < numBands; ++b)
+    {
+        bandStart[b] = juce::jlimit(0, numBins, (int)(bandEdges[b][0] / binWidth));
+        bandEnd[b]   = juce::jlimit(0, numBins, (int)(bandEdges[b][1] / binWidth));
+    }
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        float* ring   = hpssHistory.data() + bin * T;
+        float* sorted = hpssSorted.data()  + bin * T;
+        float  m      = magnitudes[bin];
+
+        sortedReplace(sorted, T, ring[hpssPos], m);
+        ring[hpssPos] = m;
+
+        // Soft (Wiener) masks split this bin's magnitude between the two parts
+        float h = sorted[T / 2];
+        float p = percussiveMedian[(size_t)bin];
+        float hh = h * h, pp = p * p;
+        float total = hh + pp;
+        float harmonicShare = total > 1.0e-12f ? hh / total : 0.5f;
+
+        float harmonicPart   = m * harmonicShare;
+        float percussivePart = m - harmonicPart;
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            if (bin < bandStart[b] || bin >= bandEnd[b]) continue;
+            harmonicSum[b]   += harmonicPart;
+            percussiveSum[b] += percussivePart;
+        }
+    }
+
+    hpssPos = (hpssPos + 1) % T;
+
+    // Auto-gain each part per band, same scheme as the main bands
+    for (int b = 0; b < numBands; ++b)
+    {
+        float count = (float)std::max(1, bandEnd[b] - bandStart[b]);
+        float hVal = harmonicSum[b] / count;
+        float pVal = percussiveSum[b] / count;
+
+        auto& hAvg = harmonicAverage[(size_t)b];
+        auto& pAvg = percussiveAverage[(size_t)b];
+        hAvg = hAvg * averageSmoothingFactor + hVal * (1.0f - averageSmoothingFactor);
+        pAvg = pAvg * averageSmoothingFactor + pVal * (1.0f - averageSmoothingFactor);
+
+        harmonicEnergy[(size_t)b].store(juce::jlimit(0.0f, 1.0f, (hVal / std::max(hAvg, minAverageThreshold)) * 0.5f));
+        percussiveEnergy[(size_t)b].store(juce::jlimit(0.0f, 1.0f, (pVal / std::max(pAvg, minAverageThreshold)) * 0.5f));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Section changes (chroma + MFCC self-similarity, checkerboard novelty)
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::MelMap::prepare(double sampleRate)
+{
+    if (sampleRate <= 0.0 || sampleRate == builtForRate)
+        return;
+
+    builtForRate = sampleRate;
+    numEntries   = 0;
+
+    auto hzToMel = [](double hz)  { return 2595.0 * std::log10(1.0 + hz / 700.0); };
+    auto melToHz = [](double mel) { return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0); };
+
+    const double binWidth = sampleRate / fftSize;
+    const double melLow   = hzToMel(kMelMinFreq);
+    const double melHigh  = hzToMel(std::min(kMelMaxFreq, sampleRate * 0.5));
+
+    // Band b is a triangle from edge b to edge b+2, peaking at edge b+1
+    double edges[numMelBands + 2];
+    for (int i = 0; i < numMelBands + 2; ++i)
+        edges[i] = melToHz(melLow + (melHigh - melLow) * i / (numMelBands + 1));
+
+    for (int bin = 1; bin < numBins; ++bin)
+    {
+        double freq = bin * binWidth;
+        for (int b = 0; b < numMelBands; ++b)
+        {
+            double lo = edges[b], mid = edges[b + 1], hi = edges[b + 2];
+            if (freq <= lo || freq >= hi) continue;
+
+            float w = (float)(freq < mid ? (freq - lo) / (mid - lo) : (hi - freq) / (hi - mid));
+            if (numEntries < (int)entries.size())
+                entries[(size_t)numEntries++] = { bin, b, w };
+        }
+    }
+
+    // DCT-II rows 1..numMfcc
+    for (int c = 0; c < numMfcc; ++c)
+        for (int b = 0; b < numMelBands; ++b)
+            dct[c][b] = (float)std::cos(juce::MathConstants<double>::pi * (c + 1) * (b + 0.5) / numMelBands);
+}
+
+void AudioVisualizerProcessor::BusAnalysis::accumulateFeatures(const float* magnitudes, const MelMap& melMap)
+{
+    float mel[numMelBands] = {};
+    for (int i = 0; i < melMap.numEntries; ++i)
+    {
+        const auto& e = melMap.entries[(size_t)i];
+        float m = magnitudes[e.bin];
+        mel[e.band] += e.weight * m * m;
+    }
+
+    for (auto& m : mel)
+        m = std::log(m + 1.0e-6f);
+
+    for (int pc = 0; pc < numPitchClasses; ++pc)
+        featureSum[(size_t)pc] += chromaSmooth[(size_t)pc];
+
+    for (int c = 0; c < numMfcc; ++c)
+    {
+        float sum = 0.0f;
+        for (int b = 0; b < numMelBands; ++b)
+            sum += melMap.dct[c][b] * mel[b];
+        featureSum[(size_t)(numPitchClasses + c)] += sum;
+    }
+
+    ++featureFrames;
+}
+
+void AudioVisualizerProcessor::BusAnalysis::processFeatureFrame()
+{
+    if (featureFrames == 0) return;
+
+    // Chroma and MFCC parts each scaled to unit length, so the cosine
+    // similarity below weighs harmony and timbre equally
+    auto& frame = featureRing[(size_t)featureRingPos];
+    auto normalisePart = [&frame, this](int start, int count)
+    {
+        float sumSq = 0.0f;
+        for (int i = start; i < start + count; ++i)
+        {
+            frame[(size_t)i] = featureSum[(size_t)i] / (float)featureFrames;
+            sumSq += frame[(size_t)i] * frame[(size_t)i];
+        }
+        float scale = sumSq > 1.0e-12f ? 1.0f / std::sqrt(sumSq) : 0.0f;
+        for (int i = start; i < start + count; ++i)
+            frame[(size_t)i] *= scale;
+    };
+    normalisePart(0, numPitchClasses);
+    normalisePart(numPitchClasses, numMfcc);
+
+    featureSum.fill(0.0f);
+    featureFrames = 0;
+
+    // One new row (and column) of the self-similarity matrix
+    featureRingCount = std::min(featureRingCount + 1, noveltyRingSize);
+    for (int j = 0; j < featureRingCount; ++j)
+    {
+        const auto& other = featureRing[(size_t)j];
+        float dot = 0.0f;
+        for (int i = 0; i < noveltyFeatureSize; ++i)
+            dot += frame[(size_t)i] * other[(size_t)i];
+
+        similarity[(size_t)featureRingPos][(size_t)j] = 0.5f * dot;   // -1..1
+        similarity[(size_t)j][(size_t)featureRingPos] = 0.5f * dot;
+    }
+
+    featureRingPos = (featureRingPos + 1) % noveltyRingSize;
+    ++framesSinceSection;
+
+    if (featureRingCount < noveltyRingSize)
+        return;
+
+    // Gaussian-tapered checkerboard centred between the older and newer halves of
+    // the ring: high when each half is self-similar and the two differ
+    constexpr int W = noveltyKernelHalf;
+    float taper[noveltyRingSize];
+    for (int a = 0; a < noveltyRingSize; ++a)
+    {
+        float offset = ((float)a - (float)W + 0.5f) / (0.5f * (float)W);
+        taper[a] = std::exp(-0.5f * offset * offset);
+    }
+
+    float score = 0.0f, weight = 0.0f;
+    for (int a = 0; a < noveltyRingSize; ++a)
+    {
+        int slotA = (featureRingPos + a) % noveltyRingSize;   // oldest first
+        for (int b = 0; b < noveltyRingSize; ++b)
+        {
+            int   slotB = (featureRingPos + b) % noveltyRingSize;
+            float k     = taper[a] * taper[b];
+            score  += ((a < W) == (b < W) ? k : -k) * similarity[(size_t)slotA][(size_t)slotB];
+            weight += k;
+        }
+    }
+    float value = score / weight;
+    novelty.store(juce::jlimit(0.0f, 1.0f, value));
+
+    // Adaptive peak picking: the previous value is a section boundary when it's
+    // a local maximum well above the recent novelty level
+    float mean = 0.0f, meanSq = 0.0f;
+    for (int i = 0; i < noveltyHistoryCount; ++i)
+    {
+        mean   += noveltyHistory[(size_t)i];
+        meanSq += noveltyHistory[(size_t)i] * noveltyHistory[(size_t)i];
+    }
+
+    if (noveltyHistoryCount >= 2)
+    {
+        mean   /= (float)noveltyHistoryCount;
+        meanSq /= (float)noveltyHistoryCount;
+        float deviation = std::sqrt(std::max(0.0f, meanSq - mean * mean));
+
+        auto at = [this](int back)
+        {
+            return noveltyHistory[(size_t)((noveltyHistoryPos - back + noveltyHistorySize) % noveltyHistorySize)];
+        };
+        float candidate = at(1), before = at(2);
+
+        if (candidate > before && candidate >= value
+         && candidate > mean + kNoveltyThreshold * deviation
+         && candidate > kNoveltyFloor
+         && framesSinceSection >= kMinSectionFrames)
+        {
+            sectionChangeCount.fetch_add(1);
+            framesSinceSection = 0;
+        }
+    }
+
+    noveltyHistory[(size_t)noveltyHistoryPos] = value;
+    noveltyHistoryPos   = (noveltyHistoryPos + 1) % noveltyHistorySize;
+    noveltyHistoryCount = std::min(noveltyHistoryCount + 1, noveltyHistorySize);
+}
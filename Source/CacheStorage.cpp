@@ -0,0 +1,29 @@
+#include "CacheStorage.h"
+
+juce::File CacheStorage::directory(const juce::String& name)
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+#if JUCE_MAC
+               .getChildFile("Application Support")
+#endif
+               .getChildFile("AudioVisualizer")
+               .getChildFile(name);
+}
+
+bool CacheStorage::writeAtomically(const juce::File& target,
+                                   const std::function<bool(juce::OutputStream&)>& writeContents)
+{
+    // Write next to the target and swap in, so a crash never leaves a torn file
+    target.getParentDirectory().createDirectory();
+    juce::TemporaryFile temp(target);
+    bool written = false;
+
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        written = writeContents(*out);
+        out->flush();
+        written = written && out->getStatus().wasOk();
+    }
+
+    return written && temp.overwriteTargetFileWithTemporary();
+}
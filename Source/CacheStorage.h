@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <type_traits>
+
+// What the on-disk caches (pre-analysed features, imported meshes) share: the
+// key hash, where they live and how a file is written so a crash never leaves a
+// torn one. Kept in one place so the caches can't drift apart.
+// (implementation in CacheStorage.cpp)
+struct CacheStorage
+{
+    // FNV-1a, fed piecewise. Also fine for in-memory keys (panelStateKey)
+    struct Hash
+    {
+        juce::uint64 value = 14695981039346656037ull;
+
+        void add(const void* data, size_t size)
+        {
+            auto* bytes = static_cast<const juce::uint8*>(data);
+            for (size_t i = 0; i < size; ++i)
+                value = (value ^ bytes[i]) * 1099511628211ull;
+        }
+
+        template <typename T>
+        void add(const T& v)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "hashes the object's bytes");
+            add(&v, sizeof(v));
+        }
+
+        juce::String toHexString() const { return juce::String::toHexString((juce::int64)value); }
+    };
+
+    // <application data>/AudioVisualizer/name; not created until something is written
+    static juce::File directory(const juce::String& name);
+
+    // Writes target through a temporary file next to it and swaps it in only if
+    // writeContents and the flush succeeded; creates the directory first.
+    // Returns true once target holds the new contents
+    static bool writeAtomically(const juce::File& target,
+                                const std::function<bool(juce::OutputStream&)>& writeContents);
+};
@@ -10,6 +10,7 @@ enum class EffectType
     Starfield,      // 3D starfield with lightspeed (current kick effect)
     FrequencyLine,  // Frequency response line for selected frequency range
     RotatingCube,   // 3D rotating cube mesh, audio-reactive
+    SpectrumBars3D, // 3D grid of spectrum bars with a scrolling history
     // Future effects can be added here:
     // Particles,
     // Waveform,
@@ -28,7 +29,46 @@ enum class FrequencyRange
     Highs,          // 4000-8000 Hz
     VeryHighs,      // 8000-20000 Hz
     KickTransient,  // Special: 50-90 Hz transient detection
-    FullSpectrum    // All frequencies
+    FullSpectrum,   // All frequencies
+
+    // Spectral descriptors (computed in the same FFT pass as the bands)
+    SpectralCentroid,   // Brightness
+    SpectralSpread,     // Bandwidth around the centroid
+    SpectralFlatness,   // Noisiness (tonal 0 .. noise 1)
+    SpectralRolloff,    // 85% energy roll-off point
+    SpectralFlux,       // Frame-to-frame spectral change
+
+    Pitch,              // Tracked monophonic pitch (vocals, leads), 50 Hz - 1.5 kHz
+
+    // Stereo field (full band)
+    StereoWidth,        // Side / (mid + side): 0 mono .. 1 out of phase
+    StereoPan,          // 0 hard left .. 0.5 centre .. 1 hard right
+    StereoCorrelation   // 0 anti-phase .. 0.5 uncorrelated .. 1 mono
+};
+
+// What drives an effect's colour
+enum class ColourSource
+{
+    Fixed,          // effectColor as picked
+    Brightness,     // effectColor shifted darker/warmer .. brighter/cooler by the spectral centroid
+    PitchClass,     // Hue from the dominant chroma pitch class (circle of fifths)
+    Pitch           // Hue sweeps with the tracked monophonic pitch (one turn per octave)
+};
+
+// Which part of the signal a band effect listens to
+enum class SignalComponent
+{
+    Mixed,          // Everything (the plain band energy)
+    Harmonic,       // Sustained, tonal content only (pads, vocals, bass notes)
+    Percussive      // Transient, broadband content only (drums, plucks)
+};
+
+// What a panel does when the music moves to a new section (drop, breakdown)
+enum class SectionAction
+{
+    None,
+    NextEffect,     // Step to the next effect type
+    NextColour      // Rotate the effect colour's hue
 };
 
 // Configuration for an effect instance
@@ -37,11 +77,19 @@ struct EffectConfig
     EffectType type = EffectType::Flutter;
     FrequencyRange frequencyRange = FrequencyRange::Mids;
     juce::Colour effectColor = juce::Colours::white;  // Color for flashes/stars
+    ColourSource colourSource = ColourSource::Fixed;
+    SignalComponent component = SignalComponent::Mixed;
+    SectionAction onSectionChange = SectionAction::None;
 
     // Effect-specific parameters
     float sensitivity = 1.0f;       // Multiplier for responsiveness
     float threshold = 0.0f;         // Minimum trigger level
     bool smoothing = true;          // Apply temporal smoothing
+    bool followStereoPan = false;   // Starfield centre drifts with the band's stereo pan
+    float starDensity = 1.0f;       // Starfield stars per unit of panel area, relative to the default
+    juce::String meshFile;          // RotatingCube model (OBJ / PLY); empty = the built-in cube
+    bool fillUnderLine = false;     // FrequencyLine fills the area under the trace with a gradient
+    bool respondToMidi = false;     // MIDI notes / CCs fire the effect alongside the audio
 
     EffectConfig() = default;
     EffectConfig(EffectType t, FrequencyRange fr)
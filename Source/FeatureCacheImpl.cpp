@@ -0,0 +1,373 @@
+#include "PluginProcessor.h"
+#include "CacheStorage.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// On-disk layout: this header, then numHops fixed-size records
+struct FeatureFileHeader {
+    char        magic[4];      // "PLFC"
+    juce::int32 version;
+    double      sampleRate;
+    juce::int32 numHops;
+    juce::int32 hopSize;
+    juce::int32 fftSize;
+    juce::int32 numBands;
+};
+
+static_assert (sizeof (FeatureFileHeader) == 32, "records must stay float-aligned");
+
+static constexpr juce::int32 kFeatureFileVersion = 1;
+
+// The cache directory is trimmed back to this, least recently used files first
+static constexpr juce::int64 kMaxFeatureCacheBytes = (juce::int64)512 * 1024 * 1024;
+
+// Spectrum bytes: 0 = silence, then -60 dB upwards in 0.5 dB steps
+static constexpr float kMinMagnitudeDb = -60.0f;
+static constexpr float kMagnitudeDbStep = 0.5f;
+
+static juce::uint8 encodeMagnitude(float magnitude)
+{
+    if (magnitude <= 0.001f)
+        return 0;
+
+    float code = 1.0f + (20.0f * std::log10(magnitude) - kMinMagnitudeDb) / kMagnitudeDbStep;
+    return (juce::uint8)juce::jlimit(1.0f, 255.0f, std::round(code));
+}
+
+static const std::array<float, 256> kMagnitudeDecode = []
+{
+    std::array<float, 256> table {};
+    for (int code = 1; code < 256; ++code)
+        table[(size_t)code] = std::pow(10.0f, (kMinMagnitudeDb + (float)(code - 1) * kMagnitudeDbStep) / 20.0f);
+    return table;
+}();
+
+// FNV-1a over the size and evenly spaced slices of the file: enough to tell files
+// apart (and spot edits) without reading a whole album on every load
+static juce::uint64 contentKey(const juce::File& file)
+{
+    constexpr int numSlices = 64;
+    constexpr int sliceSize = 4096;
+
+    juce::FileInputStream in(file);
+    if (!in.openedOk())
+        return 0;
+
+    CacheStorage::Hash hash;
+    const juce::int64 fileSize = in.getTotalLength();
+    hash.add(fileSize);
+
+    char slice[sliceSize];
+    for (int i = 0; i < numSlices; ++i)
+    {
+        in.setPosition(fileSize * i / numSlices);
+        int bytesRead = in.read(slice, sliceSize);
+        hash.add(slice, (size_t)juce::jmax(0, bytesRead));
+    }
+
+    return hash.value;
+}
+
+static juce::File featureCacheDirectory()
+{
+    return CacheStorage::directory("FeatureCache");
+}
+
+// A cache hit refreshes its file's modification time, so the oldest one is the
+// least recently used. keep is the file about to be written; a file that can't
+// be deleted (mapped by another instance, on Windows) is skipped
+static void trimFeatureCache(const juce::File& keep)
+{
+    auto files = featureCacheDirectory().findChildFiles(juce::File::findFiles, false, "*.features");
+
+    juce::int64 total = 0;
+    for (const auto& f : files)
+        total += f.getSize();
+    if (total <= kMaxFeatureCacheBytes)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+              { return a.getLastModificationTime() < b.getLastModificationTime(); });
+
+    for (const auto& f : files)
+    {
+        if (total <= kMaxFeatureCacheBytes)
+            break;
+
+        const auto size = f.getSize();
+        if (f != keep && f.deleteFile())
+            total -= size;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Loader thread
+// ---------------------------------------------------------------------------
+
+bool AudioVisualizerProcessor::FeatureCache::prepare(const juce::File& audioFile, double rate, juce::int64 length)
+{
+    sampleRate = rate;
+    numHops    = length >= fftSize ? (int)((length - fftSize) / hopSize + 1) : 0;
+
+    const auto key = contentKey(audioFile);
+    if (numHops <= 0 || key == 0)
+    {
+        failed = true;
+        return false;
+    }
+
+    cacheFile = featureCacheDirectory().getChildFile(juce::String::toHexString((juce::int64)key) + ".features");
+
+    if (openMapped())
+    {
+        cacheFile.setLastModificationTime(juce::Time::getCurrentTime());
+        ready.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // A new file is on its way; make room for it
+    trimFeatureCache(cacheFile);
+    building.allocate((size_t)numHops * recordSize, true);
+    records = building.get();
+    return false;
+}
+
+bool AudioVisualizerProcessor::FeatureCache::openMapped()
+{
+    if (!cacheFile.existsAsFile())
+        return false;
+
+    auto file = std::make_unique<juce::MemoryMappedFile>(cacheFile, juce::MemoryMappedFile::readOnly);
+    if (file->getData() == nullptr
+     || file->getSize() != sizeof(FeatureFileHeader) + (size_t)numHops * recordSize)
+        return false;
+
+    // Written by another version, or for a different rate / length: analyse again
+    const auto* header = static_cast<const FeatureFileHeader*>(file->getData());
+    if (std::memcmp(header->magic, "PLFC", 4) != 0 || header->version != kFeatureFileVersion
+     || header->sampleRate != sampleRate || header->numHops != numHops || header->hopSize != hopSize
+     || header->fftSize != fftSize || header->numBands != numBands)
+        return false;
+
+    mapped  = std::move(file);
+    records = static_cast<const char*>(mapped->getData()) + sizeof(FeatureFileHeader);
+    return true;
+}
+
+std::shared_ptr<AudioVisualizerProcessor::FeatureCache>
+AudioVisualizerProcessor::startPreAnalysis(const juce::File& file, const LoadedTrack& track)
+{
+    auto cache = std::make_shared<FeatureCache>();
+
+    if (cache->prepare(file, track.fileSampleRate, track.lengthInSamples))
+        return cache;   // analysed on an earlier load
+    if (cache->failed.load())
+        return nullptr;
+
+    // A few chunks per worker, so nobody idles while the last ones finish
+    const int hopsPerChunk = juce::jmax(1, (cache->numHops + analysisPool.getNumThreads() * 4 - 1)
+                                             / (analysisPool.getNumThreads() * 4));
+    cache->chunksRemaining = (cache->numHops + hopsPerChunk - 1) / hopsPerChunk;
+
+    for (int first = 0; first < cache->numHops; first += hopsPerChunk)
+    {
+        const int count = juce::jmin(hopsPerChunk, cache->numHops - first);
+
+        analysisPool.addJob([this, cache, file, first, count]
+        {
+            // Each chunk has its own reader, so chunks read and decode in parallel
+            if (!cache->cancelled.load())
+            {
+                std::unique_ptr<juce::AudioFormatReader> reader(createReaderFor(file));
+                if (reader != nullptr)
+                    cache->analyseChunk(*reader, first, count);
+                else
+                    cache->failed = true;
+            }
+
+            if (--cache->chunksRemaining == 0)
+                cache->finish();
+        });
+    }
+
+    return cache;
+}
+
+// ---------------------------------------------------------------------------
+// Analysis pool
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::FeatureCache::analyseChunk(juce::AudioFormatReader& reader, int firstHop, int hopCount)
+{
+    // Read in slabs of overlapping hops, so memory stays bounded for long files
+    constexpr int hopsPerSlab = 64;
+
+    juce::dsp::FFT chunkFft { fftOrder };
+    juce::dsp::WindowingFunction<float> chunkWindow { fftSize, juce::dsp::WindowingFunction<float>::hann };
+
+    const int   numChannels = juce::jlimit(1, 2, (int)reader.numChannels);
+    const float channelGain = 1.0f / (float)numChannels;
+    const float binWidth    = (float)(sampleRate / fftSize);
+
+    juce::AudioBuffer<float> slab(numChannels, (hopsPerSlab - 1) * hopSize + fftSize);
+    std::array<float, fftSize * 2> frame;
+
+    for (int slabStart = firstHop; slabStart < firstHop + hopCount; slabStart += hopsPerSlab)
+    {
+        if (cancelled.load())
+            return;
+
+        const int hops = juce::jmin(hopsPerSlab, firstHop + hopCount - slabStart);
+        if (!reader.read(&slab, 0, (hops - 1) * hopSize + fftSize, (juce::int64)slabStart * hopSize,
+                         true, numChannels > 1))
+        {
+            failed = true;
+            return;
+        }
+
+        for (int h = 0; h < hops; ++h)
+        {
+            // Same window, FFT and band kernel as the live path, on the channel mix
+            frame.fill(0.0f);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const float* source = slab.getReadPointer(ch, h * hopSize);
+                for (int i = 0; i < fftSize; ++i)
+                    frame[(size_t)i] += source[i] * channelGain;
+            }
+
+            chunkWindow.multiplyWithWindowingTable(frame.data(), fftSize);
+            chunkFft.performFrequencyOnlyForwardTransform(frame.data());
+
+            char* record = building.get() + (size_t)(slabStart + h) * recordSize;
+
+            float raw[numBands];
+            BandKernel::measure(frame.data(), binWidth, raw);
+            std::memcpy(record, raw, sizeof(raw));
+
+            auto* spectrum = reinterpret_cast<juce::uint8*>(record + sizeof(raw));
+            for (int bin = 0; bin < numBins; ++bin)
+                spectrum[bin] = encodeMagnitude(frame[(size_t)bin]);
+        }
+
+        hopsAnalysed.fetch_add(hops);
+    }
+}
+
+void AudioVisualizerProcessor::FeatureCache::finish()
+{
+    if (cancelled.load() || failed.load())
+        return;
+
+    const bool written = CacheStorage::writeAtomically(cacheFile, [this](juce::OutputStream& out)
+    {
+        FeatureFileHeader header { { 'P', 'L', 'F', 'C' }, kFeatureFileVersion, sampleRate,
+                                   numHops, hopSize, fftSize, numBands };
+        return out.write(&header, sizeof(header))
+            && out.write(building.get(), (size_t)numHops * recordSize);
+    });
+
+    // Read back through the page cache; if that fails we keep playing from the heap copy
+    if (written && openMapped())
+        building.free();
+
+    ready.store(true, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// Audio thread
+// ---------------------------------------------------------------------------
+
+int AudioVisualizerProcessor::FeatureCache::hopAt(juce::int64 filePosition) const
+{
+    return (int)juce::jlimit<juce::int64>(0, numHops - 1, (filePosition - fftSize / 2) / hopSize);
+}
+
+void AudioVisualizerProcessor::FeatureCache::readSpectrum(int hop, float* magnitudes, double deviceRate) const
+{
+    const auto* spectrum = reinterpret_cast<const juce::uint8*>(records + (size_t)hop * recordSize
+                                                                + numBands * sizeof(float));
+
+    // Device-rate bins, looked up from the file-rate spectrum
+    const double scale = deviceRate / sampleRate;
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        int source = (int)(bin * scale + 0.5);
+        magnitudes[bin] = source < numBins ? kMagnitudeDecode[spectrum[source]] : 0.0f;
+    }
+
+    // Mirrored upper half, as performFrequencyOnlyForwardTransform leaves it
+    magnitudes[numBins] = 0.0f;
+    for (int bin = 1; bin < numBins; ++bin)
+        magnitudes[fftSize - bin] = magnitudes[bin];
+}
+
+bool AudioVisualizerProcessor::readFeatureCache(int numSamples)
+{
+    const FeatureCache* features = currentTrack != nullptr ? currentTrack->features.get() : nullptr;
+    if (features == nullptr || !features->ready.load(std::memory_order_acquire))
+    {
+        lastCachedFeatures = nullptr;
+        return false;
+    }
+
+    // Past the end of the file the live path analyses the silence (and lets values fall)
+    const auto position = currentTrack->buffering->getNextReadPosition();
+    if (position >= currentTrack->lengthInSamples)
+    {
+        lastCachedFeatures = nullptr;
+        return false;
+    }
+
+    const double deviceRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    const int    hop        = features->hopAt(position);
+
+    // New track, seek, or the cache just became ready: replay the auto-gain over
+    // the preceding hops so normalization has history instead of starting cold.
+    // The replay runs on a copy and only its averages are kept; the live kick
+    // detector mustn't see those hops
+    if (features != lastCachedFeatures || hop < lastCachedHop || hop - lastCachedHop > cacheWarmupHops)
+    {
+        BandKernel replay = mainBands;
+        float normalised[numBands];
+        for (int h = juce::jmax(0, hop - cacheWarmupHops); h < hop; ++h)
+            replay.apply(features->rawBands(h), normalised);
+        mainBands.average = replay.average;
+
+        lastCachedFeatures = features;
+        lastCachedHop      = hop - 1;
+    }
+
+    const float  binWidth   = (float)deviceRate / fftSize;
+    const double blockStart = (double)position - numSamples * features->sampleRate / deviceRate;
+    chromaMap.prepare(deviceRate);
+    melMap.prepare(deviceRate);
+
+    for (int h = lastCachedHop + 1; h <= hop; ++h)
+    {
+        // Where the hop's centre falls in this block, for the MIDI notes
+        const double centre = (double)h * FeatureCache::hopSize + fftSize / 2;
+        const int sampleInBlock = juce::jlimit(0, numSamples - 1,
+                                               (int)((centre - blockStart) * deviceRate / features->sampleRate));
+
+        // Descriptors, chroma, HPSS and novelty run on the cached magnitudes; the
+        // spectrum views read them from fftData just like after a live FFT
+        features->readSpectrum(h, fftData.data(), deviceRate);
+        busAnalysis[Main].processMagnitudes(fftData.data(), binWidth, chromaMap, melMap);
+
+        float flux = busAnalysis[Main].flux.load();
+        if (flux > onsetFluxThreshold && previousFluxForOnset <= onsetFluxThreshold)
+            queueOnsetNote(1, sampleInBlock);
+        previousFluxForOnset = flux;
+
+        float normalised[numBands];
+        if (mainBands.apply(features->rawBands(h), normalised))
+            queueOnsetNote(0, sampleInBlock);
+        publishMainBands(normalised);
+    }
+
+    lastCachedHop = hop;
+    fftDataPos    = 0;   // the live path restarts on a clean frame if the cache goes away
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for per-frame scratch memory: allocate() hands out slices of one
+// block and reset() takes them all back at the start of the next frame. A frame
+// that needs more than the block holds gets the overflow from the heap, and the
+// block regrows to fit at the next reset(), so steady-state frames never touch
+// the allocator. Memory is uninitialised and nothing is destroyed, hence the
+// trivially-destructible restriction. One per render job; not thread-safe.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initialBytes = 16 * 1024)
+        : block(initialBytes), capacity(initialBytes) {}
+
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+
+        const size_t start = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        const size_t bytes = count * sizeof(T);
+        used = start + bytes;   // counts overflow too, so reset() knows what to grow to
+
+        if (used <= capacity)
+            return reinterpret_cast<T*>(block.get() + start);
+
+        overflow.emplace_back(bytes);
+        return reinterpret_cast<T*>(overflow.back().get());
+    }
+
+    void reset()
+    {
+        if (used > capacity)
+        {
+            capacity = used + used / 2;
+            block.allocate(capacity, false);
+        }
+
+        overflow.clear();
+        used = 0;
+    }
+
+private:
+    juce::HeapBlock<char> block;   // malloc-aligned, enough for any scalar type
+    size_t capacity = 0;
+    size_t used     = 0;
+    std::vector<juce::HeapBlock<char>> overflow;
+};
@@ -0,0 +1,223 @@
+#include "PluginProcessor.h"
+
+// ---------------------------------------------------------------------------
+// Loader job
+// ---------------------------------------------------------------------------
+
+AudioVisualizerProcessor::LoadedTrack::~LoadedTrack()
+{
+    // Chunk jobs still running hold their own reference; tell them to stop early
+    if (features != nullptr)
+        features->cancelled = true;
+}
+
+bool AudioVisualizerProcessor::LoadedTrack::open(juce::AudioFormatReader* newReader,
+                                                 juce::TimeSliceThread& thread,
+                                                 double readAheadSeconds,
+                                                 int blockSize, double deviceRate)
+{
+    fileSampleRate  = newReader->sampleRate;
+    lengthInSamples = newReader->lengthInSamples;
+    reader = std::make_unique<juce::AudioFormatReaderSource>(newReader, true);
+
+    if (fileSampleRate <= 0.0 || deviceRate <= 0.0)
+        return false;
+
+    // File reads and decoding happen on the read-ahead thread, never in processBlock
+    int readAheadSamples = juce::jmax(8192, (int)(readAheadSeconds * fileSampleRate));
+    buffering = std::make_unique<juce::BufferingAudioSource>(reader.get(), thread, false, readAheadSamples,
+                                                             juce::jmax(2, (int)newReader->numChannels));
+
+    // Block size in file samples; the playback resampler pulls at most this much (plus slack)
+    buffering->prepareToPlay((int)std::ceil(blockSize * fileSampleRate / deviceRate) + 4, fileSampleRate);
+
+    buffering->setNextReadPosition(0);
+    return true;
+}
+
+bool AudioVisualizerProcessor::LoadedTrack::prime(std::atomic<float>& progress, float from, float to)
+{
+    // Wait (bounded) for the first half second to be decoded, so playback
+    // starts without underruns even on slow disks
+    constexpr int attempts = 50;
+    int primeSamples = (int)juce::jmin((juce::int64)(fileSampleRate * 0.5), reader->getTotalLength());
+    if (primeSamples <= 0)
+        return true;
+
+    juce::AudioBuffer<float> probe(2, primeSamples);
+    juce::AudioSourceChannelInfo info(&probe, 0, primeSamples);
+
+    for (int i = 0; i < attempts; ++i)
+    {
+        if (buffering->waitForNextAudioBlockReady(info, 20))
+            return true;
+        progress.store(from + (to - from) * (float)(i + 1) / (float)attempts);
+    }
+
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Audio thread
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::swapInIncomingTrack()
+{
+    // Only take the new track when the old one can be queued for release
+    if (incomingTrack.load(std::memory_order_acquire) == nullptr || retiredFifo.getFreeSpace() == 0)
+        return;
+
+    if (auto* next = incomingTrack.exchange(nullptr, std::memory_order_acq_rel))
+    {
+        makeCurrent(next);
+        playbackResampler.flushBuffers();   // drop the tail of the old file
+        resetAdaptiveNormalisation();       // a new song always starts from scratch
+    }
+}
+
+bool AudioVisualizerProcessor::advanceToQueuedTrack()
+{
+    if (queuedTrack.load(std::memory_order_acquire) == nullptr || retiredFifo.getFreeSpace() == 0)
+        return false;
+
+    auto* next = queuedTrack.exchange(nullptr, std::memory_order_acq_rel);
+    if (next == nullptr)
+        return false;
+
+    makeCurrent(next);
+
+    if (normalisationPolicy.load() == (int)NormalisationPolicy::Reset)
+        resetAdaptiveNormalisation();
+
+    return true;
+}
+
+void AudioVisualizerProcessor::makeCurrent(LoadedTrack* track)
+{
+    if (currentTrack != nullptr)
+    {
+        const auto scope = retiredFifo.write(1);
+        retiredTracks[(size_t)scope.startIndex1] = currentTrack;
+    }
+
+    // The device may have changed rate since the loader prepared it (cheap, no allocation).
+    // The resampler picks the new ratio up from its next block.
+    if (getSampleRate() > 0.0)
+        playbackResampler.setResamplingRatio(track->fileSampleRate / getSampleRate());
+
+    currentTrack = track;
+    currentPlaylistIndex.store(track->playlistIndex);
+    playbackUnderruns.store(0);
+}
+
+void AudioVisualizerProcessor::readTrackSamples(const juce::AudioSourceChannelInfo& info)
+{
+    int done = 0;
+
+    while (done < info.numSamples && currentTrack != nullptr)
+    {
+        const auto remaining = currentTrack->lengthInSamples - currentTrack->buffering->getNextReadPosition();
+
+        // End of the file: splice the prefetched track in at this exact frame
+        if (remaining <= 0)
+        {
+            if (!advanceToQueuedTrack())
+                break;
+            continue;
+        }
+
+        juce::AudioSourceChannelInfo segment(info.buffer, info.startSample + done,
+                                             (int)juce::jmin((juce::int64)(info.numSamples - done), remaining));
+
+        // Count segments the read-ahead thread hasn't filled yet (they play as silence)
+        if (!currentTrack->buffering->waitForNextAudioBlockReady(segment, 0))
+            playbackUnderruns.fetch_add(1);
+
+        currentTrack->buffering->getNextAudioBlock(segment);
+        done += segment.numSamples;
+    }
+
+    // Past the end of the last track (or nothing queued in time): silence
+    if (done < info.numSamples)
+        info.buffer->clear(info.startSample + done, info.numSamples - done);
+}
+
+void AudioVisualizerProcessor::resetAdaptiveNormalisation()
+{
+    mainBands.reset();
+
+    for (auto& analysis : busAnalysis)
+    {
+        analysis.fluxAverage = 0.0f;
+        analysis.harmonicAverage.fill(0.0f);
+        analysis.percussiveAverage.fill(0.0f);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Message thread
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::releaseRetiredTracks()
+{
+    const auto scope = retiredFifo.read(retiredFifo.getNumReady());
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        delete retiredTracks[(size_t)(scope.startIndex1 + i)];
+    for (int i = 0; i < scope.blockSize2; ++i)
+        delete retiredTracks[(size_t)(scope.startIndex2 + i)];
+}
+
+void AudioVisualizerProcessor::prefetchNextTrack()
+{
+    const int current = currentPlaylistIndex.load();
+    if (playlist.isEmpty() || current < 0 || current >= playlist.size() || prefetchInFlight.load()
+     || queuedTrack.load(std::memory_order_acquire) != nullptr)
+        return;
+
+    if (current + 1 >= playlist.size() && !playlistLoops)
+        return;
+
+    const int generation = loadGeneration.load();
+    prefetchInFlight = true;
+
+    // The pool has a single thread, so this never overlaps a load job
+    loaderPool.addJob([this, files = playlist, loop = playlistLoops, current, generation]
+    {
+        // Skip entries that can't be opened rather than stalling the playlist on them
+        for (int step = 1; step <= files.size(); ++step)
+        {
+            const int next = current + step;
+            if (next >= files.size() && !loop)
+                break;
+
+            auto* reader = createReaderFor(files[next % files.size()]);
+            auto track = std::make_unique<LoadedTrack>();
+
+            if (reader == nullptr
+             || !track->open(reader, readAheadThread, readAheadSeconds.load(),
+                             preparedBlockSize.load(), preparedSampleRate.load()))
+                continue;
+
+            std::atomic<float> unusedProgress { 0.0f };
+            track->prime(unusedProgress, 0.0f, 1.0f);
+            track->playlistIndex = next % files.size();
+
+            if (preAnalysisEnabled.load())
+                track->features = startPreAnalysis(files[next % files.size()], *track);
+
+            // A new load or playlist since we started makes this one stale
+            if (loadGeneration.load() == generation)
+                delete queuedTrack.exchange(track.release(), std::memory_order_acq_rel);
+            break;
+        }
+
+        prefetchInFlight = false;
+    });
+}
+
+void AudioVisualizerProcessor::timerCallback()
+{
+    releaseRetiredTracks();
+    prefetchNextTrack();
+}
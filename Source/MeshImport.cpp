@@ -0,0 +1,820 @@
+#include "MeshImport.h"
+#include "CacheStorage.h"
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+
+using Mesh = Render3D::Mesh;
+using Face = std::array<int, 4>;   // corner 3 < 0: a triangle
+
+static bool cancelled()
+{
+    auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+    return job != nullptr && job->shouldExit();
+}
+
+// Quads stay quads; anything larger becomes a triangle fan
+static void addPolygon(Mesh& mesh, const int* corners, int count)
+{
+    if (count == 4)
+    {
+        mesh.faces.push_back({ corners[0], corners[1], corners[2], corners[3] });
+        return;
+    }
+
+    for (int i = 1; i + 1 < count; ++i)
+        mesh.faces.push_back({ corners[0], corners[i], corners[i + 1], -1 });
+}
+
+// A negative corner read from a file (a relative OBJ index reaching past the
+// first vertex, a signed PLY value) would pass for the triangle marker once it
+// is in a Face, so the parsers reject it before addPolygon
+static bool hasNegativeIndex(const std::vector<int>& polygon)
+{
+    return std::any_of(polygon.begin(), polygon.end(), [](int i) { return i < 0; });
+}
+
+// Only the -1 that addPolygon writes marks a triangle
+static bool validIndices(const Mesh& mesh)
+{
+    const int numVertices = (int)mesh.z.size();
+    for (const auto& f : mesh.faces)
+        for (int k = 0; k < 4; ++k)
+            if (f[(size_t)k] >= numVertices || (f[(size_t)k] < 0 && (k < 3 || f[(size_t)k] != -1)))
+                return false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Text helpers (the buffers are null-terminated)
+// ---------------------------------------------------------------------------
+
+static void skipSpaces(const char*& p)
+{
+    while (*p == ' ' || *p == '\t')
+        ++p;
+}
+
+static void skipLine(const char*& p)
+{
+    while (*p != 0 && *p != '\n')
+        ++p;
+    if (*p == '\n')
+        ++p;
+}
+
+// Locale-independent, unlike strtod
+static double readNumber(const char*& p)
+{
+    skipSpaces(p);
+    juce::CharPointer_ASCII text(p);
+    const double value = juce::CharacterFunctions::readDoubleValue(text);
+    p = text.getAddress();
+    return value;
+}
+
+static bool readInteger(const char*& p, long& value)
+{
+    skipSpaces(p);
+    if (!((*p >= '0' && *p <= '9') || *p == '-' || *p == '+'))
+        return false;
+
+    char* end = nullptr;
+    value = std::strtol(p, &end, 10);
+    if (end == p)
+        return false;
+
+    p = end;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// OBJ
+// ---------------------------------------------------------------------------
+
+static bool parseObj(const juce::MemoryBlock& data, Mesh& mesh, juce::String& error)
+{
+    const char* p = static_cast<const char*>(data.getData());
+    std::vector<int> polygon;
+    int lineCount = 0;
+
+    while (*p != 0)
+    {
+        if ((++lineCount & 0xffff) == 0 && cancelled())
+        {
+            error = "Import cancelled";
+            return false;
+        }
+
+        skipSpaces(p);
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            ++p;
+            mesh.x.push_back((float)readNumber(p));
+            mesh.y.push_back((float)readNumber(p));
+            mesh.z.push_back((float)readNumber(p));
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            ++p;
+            polygon.clear();
+
+            // 1-based, or negative = counted back from the last vertex so far;
+            // texture and normal references after the slashes are ignored
+            long index;
+            while (readInteger(p, index))
+            {
+                polygon.push_back(index > 0 ? (int)(index - 1) : (int)mesh.z.size() + (int)index);
+                while (*p != 0 && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                    ++p;
+            }
+
+            if (hasNegativeIndex(polygon))
+            {
+                error = "Face refers to a vertex before the first one";
+                return false;
+            }
+            if (polygon.size() >= 3)
+                addPolygon(mesh, polygon.data(), (int)polygon.size());
+        }
+
+        skipLine(p);
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// PLY (ascii and binary, either byte order)
+// ---------------------------------------------------------------------------
+
+enum PlyType { plyInvalid, plyInt8, plyUInt8, plyInt16, plyUInt16, plyInt32, plyUInt32, plyFloat32, plyFloat64 };
+
+static PlyType plyType(const juce::String& name)
+{
+    if (name == "char"   || name == "int8")    return plyInt8;
+    if (name == "uchar"  || name == "uint8")   return plyUInt8;
+    if (name == "short"  || name == "int16")   return plyInt16;
+    if (name == "ushort" || name == "uint16")  return plyUInt16;
+    if (name == "int"    || name == "int32")   return plyInt32;
+    if (name == "uint"   || name == "uint32")  return plyUInt32;
+    if (name == "float"  || name == "float32") return plyFloat32;
+    if (name == "double" || name == "float64") return plyFloat64;
+    return plyInvalid;
+}
+
+static int plySize(PlyType type)
+{
+    switch (type)
+    {
+        case plyInt8:  case plyUInt8:                    return 1;
+        case plyInt16: case plyUInt16:                   return 2;
+        case plyInt32: case plyUInt32: case plyFloat32:  return 4;
+        case plyFloat64:                                 return 8;
+        case plyInvalid: default:                        return 0;
+    }
+}
+
+struct PlyProperty
+{
+    juce::String name;
+    PlyType type      = plyInvalid;
+    PlyType countType = plyInvalid;   // lists only
+    bool    isList    = false;
+};
+
+struct PlyElement
+{
+    juce::String name;
+    juce::int64  count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+class PlyReader
+{
+public:
+    enum class Format { ascii, littleEndian, bigEndian };
+
+    PlyReader(const char* start, const char* end, Format f) : p(start), limit(end), format(f) {}
+
+    bool read(PlyType type, double& value)
+    {
+        if (format == Format::ascii)
+        {
+            while (p < limit && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+                ++p;
+            if (p >= limit)
+                return false;
+
+            value = readNumber(p);
+            return true;
+        }
+
+        const int size = plySize(type);
+        if (limit - p < size)
+            return false;
+
+        juce::uint8 bytes[8];
+        std::memcpy(bytes, p, (size_t)size);
+        p += size;
+
+        const bool swap = (format == Format::bigEndian) != (juce::ByteOrder::isBigEndian());
+        if (swap)
+            std::reverse(bytes, bytes + size);
+
+        switch (type)
+        {
+            case plyInt8:    { juce::int8   v; std::memcpy(&v, bytes, 1); value = v; break; }
+            case plyUInt8:   { juce::uint8  v; std::memcpy(&v, bytes, 1); value = v; break; }
+            case plyInt16:   { juce::int16  v; std::memcpy(&v, bytes, 2); value = v; break; }
+            case plyUInt16:  { juce::uint16 v; std::memcpy(&v, bytes, 2); value = v; break; }
+            case plyInt32:   { juce::int32  v; std::memcpy(&v, bytes, 4); value = v; break; }
+            case plyUInt32:  { juce::uint32 v; std::memcpy(&v, bytes, 4); value = v; break; }
+            case plyFloat32: { float        v; std::memcpy(&v, bytes, 4); value = v; break; }
+            case plyFloat64: { double       v; std::memcpy(&v, bytes, 8); value = v; break; }
+            case plyInvalid: default: return false;
+        }
+        return true;
+    }
+
+private:
+    const char* p;
+    const char* limit;
+    Format format;
+};
+
+static bool parsePly(const juce::MemoryBlock& data, Mesh& mesh, juce::String& error)
+{
+    const char* begin = static_cast<const char*>(data.getData());
+    const char* end   = begin + data.getSize() - 1;   // before the terminator load() appends
+    const char* headerEnd = std::strstr(begin, "end_header");
+
+    if (std::strncmp(begin, "ply", 3) != 0 || headerEnd == nullptr)
+    {
+        error = "Not a PLY file";
+        return false;
+    }
+
+    auto format = PlyReader::Format::ascii;
+    std::vector<PlyElement> elements;
+
+    for (auto& line : juce::StringArray::fromLines(juce::String(begin, (size_t)(headerEnd - begin))))
+    {
+        auto tokens = juce::StringArray::fromTokens(line.trim(), false);
+        if (tokens.isEmpty())
+            continue;
+
+        if (tokens[0] == "format")
+        {
+            if (tokens[1] == "binary_little_endian")   format = PlyReader::Format::littleEndian;
+            else if (tokens[1] == "binary_big_endian") format = PlyReader::Format::bigEndian;
+        }
+        else if (tokens[0] == "element" && tokens.size() >= 3)
+        {
+            elements.push_back({ tokens[1], tokens[2].getLargeIntValue(), {} });
+        }
+        else if (tokens[0] == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            if (tokens[1] == "list" && tokens.size() >= 5)
+            {
+                property.isList    = true;
+                property.countType = plyType(tokens[2]);
+                property.type      = plyType(tokens[3]);
+                property.name      = tokens[4];
+            }
+            else if (tokens.size() >= 3)
+            {
+                property.type = plyType(tokens[1]);
+                property.name = tokens[2];
+            }
+
+            if (property.type == plyInvalid || (property.isList && property.countType == plyInvalid))
+            {
+                error = "Unsupported PLY property: " + line;
+                return false;
+            }
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    const char* body = headerEnd;
+    skipLine(body);
+    PlyReader reader(body, end, format);
+    std::vector<int> polygon;
+
+    for (const auto& element : elements)
+    {
+        const bool isVertex = element.name == "vertex";
+        const bool isFace   = element.name == "face";
+
+        for (juce::int64 i = 0; i < element.count; ++i)
+        {
+            if ((i & 0xffff) == 0 && cancelled())
+            {
+                error = "Import cancelled";
+                return false;
+            }
+
+            float position[3] = { 0.0f, 0.0f, 0.0f };
+            polygon.clear();
+
+            for (const auto& property : element.properties)
+            {
+                double value = 0.0;
+
+                if (property.isList)
+                {
+                    if (!reader.read(property.countType, value))
+                        { error = "Truncated PLY file"; return false; }
+
+                    const bool isIndices = isFace && (property.name == "vertex_indices" || property.name == "vertex_index");
+                    const int count = (int)value;
+                    for (int k = 0; k < count; ++k)
+                    {
+                        if (!reader.read(property.type, value))
+                            { error = "Truncated PLY file"; return false; }
+                        if (isIndices)
+                            polygon.push_back((int)value);
+                    }
+                    continue;
+                }
+
+                if (!reader.read(property.type, value))
+                    { error = "Truncated PLY file"; return false; }
+
+                if (isVertex)
+                {
+                    if (property.name == "x")      position[0] = (float)value;
+                    else if (property.name == "y") position[1] = (float)value;
+                    else if (property.name == "z") position[2] = (float)value;
+                }
+            }
+
+            if (isVertex)
+            {
+                mesh.x.push_back(position[0]);
+                mesh.y.push_back(position[1]);
+                mesh.z.push_back(position[2]);
+            }
+            else if (isFace && hasNegativeIndex(polygon))
+            {
+                error = "Negative vertex index in PLY face";
+                return false;
+            }
+            else if (isFace && polygon.size() >= 3)
+            {
+                addPolygon(mesh, polygon.data(), (int)polygon.size());
+            }
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Clean-up
+// ---------------------------------------------------------------------------
+
+// Centre on the bounding box and scale the largest half-extent to 1. Files are
+// y-up and face +z; the renderer is y-down and looks along +z, so the mesh is
+// also turned half a turn about x (a rotation, so windings keep their meaning)
+static bool normalise(Mesh& mesh)
+{
+    if (mesh.z.empty())
+        return false;
+
+    float lo[3] = { mesh.x[0], mesh.y[0], mesh.z[0] };
+    float hi[3] = { mesh.x[0], mesh.y[0], mesh.z[0] };
+    for (size_t i = 1; i < mesh.z.size(); ++i)
+    {
+        lo[0] = std::min(lo[0], mesh.x[i]); hi[0] = std::max(hi[0], mesh.x[i]);
+        lo[1] = std::min(lo[1], mesh.y[i]); hi[1] = std::max(hi[1], mesh.y[i]);
+        lo[2] = std::min(lo[2], mesh.z[i]); hi[2] = std::max(hi[2], mesh.z[i]);
+    }
+
+    const float extent = 0.5f * std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] });
+    if (!(extent > 0.0f) || !std::isfinite(extent))
+        return false;
+
+    const float cx = 0.5f * (lo[0] + hi[0]), cy = 0.5f * (lo[1] + hi[1]), cz = 0.5f * (lo[2] + hi[2]);
+    for (size_t i = 0; i < mesh.z.size(); ++i)
+    {
+        mesh.x[i] =  (mesh.x[i] - cx) / extent;
+        mesh.y[i] = -(mesh.y[i] - cy) / extent;
+        mesh.z[i] = -(mesh.z[i] - cz) / extent;
+    }
+    return true;
+}
+
+// Merge vertices that coincide (to 1e-5 of the normalised size), which OBJ
+// exporters duplicate per UV / normal seam
+static void weld(Mesh& mesh)
+{
+    static constexpr float tolerance = 1.0e-5f;
+
+    struct Key
+    {
+        juce::int64 x, y, z;
+        bool operator== (const Key& o) const { return x == o.x && y == o.y && z == o.z; }
+    };
+    struct KeyHash
+    {
+        size_t operator() (const Key& k) const
+        {
+            return (size_t)(k.x * 73856093ll ^ k.y * 19349663ll ^ k.z * 83492791ll);
+        }
+    };
+
+    std::unordered_map<Key, int, KeyHash> unique;
+    unique.reserve(mesh.z.size());
+    std::vector<int> remap(mesh.z.size());
+    Mesh welded;
+
+    for (size_t i = 0; i < mesh.z.size(); ++i)
+    {
+        const Key key { std::llround(mesh.x[i] / tolerance), std::llround(mesh.y[i] / tolerance),
+                        std::llround(mesh.z[i] / tolerance) };
+        auto inserted = unique.emplace(key, (int)welded.z.size());
+        if (inserted.second)
+        {
+            welded.x.push_back(mesh.x[i]);
+            welded.y.push_back(mesh.y[i]);
+            welded.z.push_back(mesh.z[i]);
+        }
+        remap[i] = inserted.first->second;
+    }
+
+    for (auto& f : mesh.faces)
+        for (auto& c : f)
+            if (c >= 0) c = remap[(size_t)c];
+
+    mesh.x = std::move(welded.x);
+    mesh.y = std::move(welded.y);
+    mesh.z = std::move(welded.z);
+}
+
+// Collapse repeated corners; faces left with fewer than three are dropped
+static void removeDegenerateFaces(Mesh& mesh)
+{
+    size_t kept = 0;
+    for (const auto& f : mesh.faces)
+    {
+        int corners[4];
+        int n = 0;
+        const int count = f[3] < 0 ? 3 : 4;
+        for (int k = 0; k < count; ++k)
+        {
+            bool repeat = false;
+            for (int j = 0; j < n; ++j)
+                repeat = repeat || corners[j] == f[(size_t)k];
+            if (!repeat)
+                corners[n++] = f[(size_t)k];
+        }
+
+        if (n >= 3)
+            mesh.faces[kept++] = { corners[0], corners[1], corners[2], n == 4 ? corners[3] : -1 };
+    }
+    mesh.faces.resize(kept);
+}
+
+// Newell's method (robust for slightly non-planar quads); zero-area faces are dropped
+static void computeNormals(Mesh& mesh)
+{
+    mesh.normals.resize(mesh.faces.size());
+    size_t kept = 0;
+
+    for (size_t i = 0; i < mesh.faces.size(); ++i)
+    {
+        const auto f = mesh.faces[i];
+        const int count = f[3] < 0 ? 3 : 4;
+        float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+
+        for (int k = 0; k < count; ++k)
+        {
+            const auto a = (size_t)f[(size_t)k], b = (size_t)f[(size_t)((k + 1) % count)];
+            nx += (mesh.y[a] - mesh.y[b]) * (mesh.z[a] + mesh.z[b]);
+            ny += (mesh.z[a] - mesh.z[b]) * (mesh.x[a] + mesh.x[b]);
+            nz += (mesh.x[a] - mesh.x[b]) * (mesh.y[a] + mesh.y[b]);
+        }
+
+        const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (length < 1.0e-12f)
+            continue;
+
+        mesh.faces[kept]   = f;
+        mesh.normals[kept] = { nx / length, ny / length, nz / length };
+        ++kept;
+    }
+
+    mesh.faces.resize(kept);
+    mesh.normals.resize(kept);
+}
+
+static juce::uint32 spreadBits(juce::uint32 v)   // 10 bits -> every third bit
+{
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8))  & 0x0300f00f;
+    v = (v | (v << 4))  & 0x030c30c3;
+    v = (v | (v << 2))  & 0x09249249;
+    return v;
+}
+
+// Faces sorted along a Morton curve through their centroids, then vertices
+// numbered in first-use order (unused ones dropped), so neighbouring faces share
+// cache lines in every per-frame loop
+static void optimiseOrder(Mesh& mesh)
+{
+    std::vector<std::pair<juce::uint32, juce::uint32>> order(mesh.faces.size());
+    for (size_t i = 0; i < mesh.faces.size(); ++i)
+    {
+        const auto& f = mesh.faces[i];
+        const int count = f[3] < 0 ? 3 : 4;
+        float c[3] = { 0.0f, 0.0f, 0.0f };
+        for (int k = 0; k < count; ++k)
+        {
+            c[0] += mesh.x[(size_t)f[(size_t)k]];
+            c[1] += mesh.y[(size_t)f[(size_t)k]];
+            c[2] += mesh.z[(size_t)f[(size_t)k]];
+        }
+
+        juce::uint32 code = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float unit = juce::jlimit(0.0f, 1.0f, (c[axis] / (float)count + 1.0f) * 0.5f);
+            code |= spreadBits((juce::uint32)(unit * 1023.0f)) << axis;
+        }
+        order[i] = { code, (juce::uint32)i };
+    }
+    std::sort(order.begin(), order.end());
+
+    Mesh sorted;
+    sorted.faces.reserve(mesh.faces.size());
+    sorted.normals.reserve(mesh.faces.size());
+    std::vector<int> remap(mesh.z.size(), -1);
+
+    for (const auto& entry : order)
+    {
+        auto f = mesh.faces[entry.second];
+        for (auto& c : f)
+        {
+            if (c < 0) continue;
+            if (remap[(size_t)c] < 0)
+            {
+                remap[(size_t)c] = (int)sorted.z.size();
+                sorted.x.push_back(mesh.x[(size_t)c]);
+                sorted.y.push_back(mesh.y[(size_t)c]);
+                sorted.z.push_back(mesh.z[(size_t)c]);
+            }
+            c = remap[(size_t)c];
+        }
+        sorted.faces.push_back(f);
+        sorted.normals.push_back(mesh.normals[entry.second]);
+    }
+
+    mesh = std::move(sorted);
+}
+
+static bool finishMesh(Mesh& mesh)
+{
+    removeDegenerateFaces(mesh);
+    computeNormals(mesh);
+    optimiseOrder(mesh);
+    return !mesh.faces.empty();
+}
+
+// ---------------------------------------------------------------------------
+// Level of detail
+// ---------------------------------------------------------------------------
+
+// Vertex clustering: every vertex in a grid cell merges into the cell's mean
+static Mesh clusterVertices(const Mesh& source, int gridSize)
+{
+    std::unordered_map<juce::uint32, int> cells;
+    std::vector<int> remap(source.z.size());
+    std::vector<float> sums;
+    std::vector<int> counts;
+
+    auto cellOf = [gridSize](float v)
+    {
+        return (juce::uint32)juce::jlimit(0, gridSize - 1, (int)((v + 1.0f) * 0.5f * (float)gridSize));
+    };
+
+    for (size_t i = 0; i < source.z.size(); ++i)
+    {
+        const juce::uint32 id = (cellOf(source.x[i]) * (juce::uint32)gridSize + cellOf(source.y[i]))
+                              * (juce::uint32)gridSize + cellOf(source.z[i]);
+        auto inserted = cells.emplace(id, (int)counts.size());
+        if (inserted.second)
+        {
+            sums.insert(sums.end(), { 0.0f, 0.0f, 0.0f });
+            counts.push_back(0);
+        }
+
+        const auto cell = (size_t)inserted.first->second;
+        sums[cell * 3 + 0] += source.x[i];
+        sums[cell * 3 + 1] += source.y[i];
+        sums[cell * 3 + 2] += source.z[i];
+        ++counts[cell];
+        remap[i] = (int)cell;
+    }
+
+    Mesh lod;
+    for (size_t cell = 0; cell < counts.size(); ++cell)
+    {
+        lod.x.push_back(sums[cell * 3 + 0] / (float)counts[cell]);
+        lod.y.push_back(sums[cell * 3 + 1] / (float)counts[cell]);
+        lod.z.push_back(sums[cell * 3 + 2] / (float)counts[cell]);
+    }
+
+    lod.faces = source.faces;
+    for (auto& f : lod.faces)
+        for (auto& c : f)
+            if (c >= 0) c = remap[(size_t)c];
+
+    finishMesh(lod);
+    return lod;
+}
+
+static void buildLods(ImportedMesh& mesh)
+{
+    static constexpr size_t minFaces = 64;
+
+    for (int grid = 256; grid >= 8 && !cancelled(); grid /= 2)
+    {
+        const size_t finerFaces = mesh.lods.back().faces.size();
+        if (finerFaces <= minFaces)
+            break;
+
+        // Always clustered from full detail; only levels that save enough are kept
+        auto lod = clusterVertices(mesh.lods.front(), grid);
+        if (!lod.faces.empty() && lod.faces.size() * 10 < finerFaces * 7)
+            mesh.lods.push_back(std::move(lod));
+    }
+}
+
+const Render3D::Mesh& ImportedMesh::forPixelArea(float pixelArea) const
+{
+    const float budget = pixelArea / pixelsPerFace;
+    for (const auto& lod : lods)
+        if ((float)lod.faces.size() <= budget)
+            return lod;
+    return lods.back();
+}
+
+// ---------------------------------------------------------------------------
+// Binary cache
+// ---------------------------------------------------------------------------
+
+// On-disk layout: this header, then per level the vertex and face counts (int32)
+// followed by x[], y[], z[], faces[] (4 x int32) and normals[] (3 x float)
+struct MeshFileHeader {
+    char        magic[4];      // "PLMS"
+    juce::int32 version;
+    juce::int32 numLods;
+    juce::int32 reserved;
+};
+
+static constexpr juce::int32 kMeshFileVersion = 1;
+
+// Keyed on the file's path, size and modification time, so an edited file re-imports
+static juce::File meshCacheFile(const juce::File& source)
+{
+    CacheStorage::Hash hash;
+    const auto path = source.getFullPathName().toStdString();
+    hash.add(path.data(), path.size());
+    hash.add(source.getSize());
+    hash.add(source.getLastModificationTime().toMilliseconds());
+
+    return CacheStorage::directory("MeshCache").getChildFile(hash.toHexString() + ".mesh");
+}
+
+static bool readCache(const juce::File& cacheFile, ImportedMesh& mesh)
+{
+    juce::MemoryBlock data;
+    if (!cacheFile.existsAsFile() || !cacheFile.loadFileAsData(data))
+        return false;
+
+    juce::MemoryInputStream in(data, false);
+    MeshFileHeader header;
+    if (in.read(&header, sizeof(header)) != (int)sizeof(header)
+     || std::memcmp(header.magic, "PLMS", 4) != 0 || header.version != kMeshFileVersion || header.numLods <= 0)
+        return false;
+
+    auto readArray = [&in](void* dest, size_t bytes)
+    {
+        return in.getNumBytesRemaining() >= (juce::int64)bytes && in.read(dest, (int)bytes) == (int)bytes;
+    };
+
+    for (int l = 0; l < header.numLods; ++l)
+    {
+        juce::int32 numVertices = 0, numFaces = 0;
+        if (!readArray(&numVertices, sizeof(numVertices)) || !readArray(&numFaces, sizeof(numFaces))
+         || numVertices <= 0 || numFaces <= 0)
+            return false;
+
+        Mesh lod;
+        lod.x.resize((size_t)numVertices);
+        lod.y.resize((size_t)numVertices);
+        lod.z.resize((size_t)numVertices);
+        lod.faces.resize((size_t)numFaces);
+        lod.normals.resize((size_t)numFaces);
+
+        if (!readArray(lod.x.data(), lod.x.size() * sizeof(float))
+         || !readArray(lod.y.data(), lod.y.size() * sizeof(float))
+         || !readArray(lod.z.data(), lod.z.size() * sizeof(float))
+         || !readArray(lod.faces.data(), lod.faces.size() * sizeof(Face))
+         || !readArray(lod.normals.data(), lod.normals.size() * sizeof(Render3D::Vec3))
+         || !validIndices(lod))
+            return false;
+
+        mesh.lods.push_back(std::move(lod));
+    }
+    return true;
+}
+
+static void writeCache(const juce::File& cacheFile, const ImportedMesh& mesh)
+{
+    CacheStorage::writeAtomically(cacheFile, [&mesh](juce::OutputStream& out)
+    {
+        MeshFileHeader header { { 'P', 'L', 'M', 'S' }, kMeshFileVersion, (juce::int32)mesh.lods.size(), 0 };
+        bool written = out.write(&header, sizeof(header));
+
+        for (const auto& lod : mesh.lods)
+        {
+            const juce::int32 counts[2] = { (juce::int32)lod.z.size(), (juce::int32)lod.faces.size() };
+            written = written
+                   && out.write(counts, sizeof(counts))
+                   && out.write(lod.x.data(), lod.x.size() * sizeof(float))
+                   && out.write(lod.y.data(), lod.y.size() * sizeof(float))
+                   && out.write(lod.z.data(), lod.z.size() * sizeof(float))
+                   && out.write(lod.faces.data(), lod.faces.size() * sizeof(Face))
+                   && out.write(lod.normals.data(), lod.normals.size() * sizeof(Render3D::Vec3));
+        }
+        return written;
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Import
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<const ImportedMesh> MeshImporter::load(const juce::File& file, juce::String& error)
+{
+    auto result = std::make_shared<ImportedMesh>();
+    const auto cacheFile = meshCacheFile(file);
+
+    if (readCache(cacheFile, *result))
+        return result;
+
+    result->lods.clear();
+
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data))
+    {
+        error = "Couldn't read " + file.getFileName();
+        return nullptr;
+    }
+    data.append("", 1);   // terminator for the text parsers
+
+    Mesh mesh;
+    const bool parsed = file.hasFileExtension("ply") ? parsePly(data, mesh, error)
+                                                     : parseObj(data, mesh, error);
+    if (!parsed)
+        return nullptr;
+
+    if (!validIndices(mesh))
+    {
+        error = file.getFileName() + " has faces referring to missing vertices";
+        return nullptr;
+    }
+
+    if (!normalise(mesh))
+    {
+        error = file.getFileName() + " has no usable geometry";
+        return nullptr;
+    }
+
+    weld(mesh);
+    if (!finishMesh(mesh))
+    {
+        error = file.getFileName() + " has no faces";
+        return nullptr;
+    }
+
+    result->lods.push_back(std::move(mesh));
+    buildLods(*result);
+
+    if (cancelled())
+    {
+        error = "Import cancelled";
+        return nullptr;
+    }
+
+    writeCache(cacheFile, *result);
+    return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include "Render3D.h"
+
+// A mesh imported for the 3D effects, normalised to -1..1 like Render3D's unit box,
+// with its level-of-detail chain
+struct ImportedMesh
+{
+    std::vector<Render3D::Mesh> lods;   // lods[0] is full detail, each next about half the faces
+
+    // The finest level that fits the face budget of a panel this many pixels in area
+    static constexpr float pixelsPerFace = 48.0f;
+    const Render3D::Mesh& forPixelArea(float pixelArea) const;
+};
+
+// OBJ / PLY import. load() reads the file (or its cached binary form), welds
+// duplicate vertices, drops degenerate faces, precomputes face normals, orders
+// faces and vertices for locality, builds the LOD chain by vertex clustering and
+// caches the result. It blocks, so call it off the message thread; inside a
+// ThreadPool job it gives up when the job is asked to exit.
+// (implementation in MeshImport.cpp)
+struct MeshImporter
+{
+    static std::shared_ptr<const ImportedMesh> load(const juce::File& file, juce::String& error);
+
+    static bool canImport(const juce::File& file)
+    {
+        return file.hasFileExtension("obj;ply");
+    }
+};
@@ -1,5 +1,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SoftwareRaster.h"
+#include "CacheStorage.h"
 
 // =============================================================================
 // Constructor / Destructor
@@ -46,12 +48,19 @@ AudioVisualizerEditor::AudioVisualizerEditor (AudioVisualizerProcessor& p)
                 dw->setUsingNativeTitleBar(true);
     });
 
-    startTimerHz(60);
+    pendingMidiTriggers.reserve(256);
+    startTimerHz(fallbackTimerHz);
 }
 
 AudioVisualizerEditor::~AudioVisualizerEditor()
 {
+    // Jobs hold references to panels; let the running ones finish first
+    renderPool.removeAllJobs(true, -1);
+    meshLoadPool.removeAllJobs(true, -1);
     saveStateToProcessor();
+
+    for (int slot = 0; slot < AudioVisualizerProcessor::maxResonatorBanks; ++slot)
+        audioProcessor.releaseResonatorBank(slot);
 }
 
 // =============================================================================
@@ -65,6 +74,7 @@ int AudioVisualizerEditor::createPanel(EffectConfig cfg,
     panel->id     = nextPanelId++;
     panel->config  = cfg;
     panel->procID  = procID;
+    panel->starfield.seed = (juce::uint64)panel->id + 1;
     int id = panel->id;
     panels.push_back(std::move(panel));
     return id;
@@ -110,6 +120,7 @@ void AudioVisualizerEditor::closePanel(int panelId)
 
     layoutRoot = removeNode(std::move(layoutRoot), panelId);
 
+    waitForPanelRenders();
     panels.erase(std::remove_if(panels.begin(), panels.end(),
         [panelId](const auto& p) { return p->id == panelId; }),
         panels.end());
@@ -331,9 +342,38 @@ void AudioVisualizerEditor::execDrop(int dzIdx)
 // Audio value helpers
 // =============================================================================
 
+// Tracked pitch on a log axis across the tracker's 50 Hz - 1.5 kHz range
+static float normalisePitch(float hz)
+{
+    if (hz <= 50.0f) return 0.0f;
+    return juce::jlimit(0.0f, 1.0f, std::log2(hz / 50.0f) / std::log2(1500.0f / 50.0f));
+}
+
+// Stereo analysis is per band; non-band sources use the full band
+static int stereoBandFor(FrequencyRange range)
+{
+    int band = (int)range;
+    return band <= (int)FrequencyRange::FullSpectrum ? band : (int)FrequencyRange::FullSpectrum;
+}
+
+// Fades a pitch-derived value in as the tracker becomes sure of itself
+static float pitchGate(float confidence)
+{
+    return juce::jlimit(0.0f, 1.0f, (confidence - 0.4f) / 0.4f);
+}
+
 float AudioVisualizerEditor::getFrequencyValue(FrequencyRange range,
-                                                 AudioVisualizerProcessor::PanelID panel)
+                                                 AudioVisualizerProcessor::PanelID panel,
+                                                 SignalComponent component)
 {
+    // Separated energies exist for the bands only; everything else reads the mixed value
+    if (component != SignalComponent::Mixed && (int)range <= (int)FrequencyRange::FullSpectrum)
+    {
+        return component == SignalComponent::Harmonic
+             ? audioProcessor.getHarmonicEnergy(panel, (int)range)
+             : audioProcessor.getPercussiveEnergy(panel, (int)range);
+    }
+
     switch (range)
     {
         case FrequencyRange::SubBass:       return audioProcessor.getSubBassEnergy(panel);
@@ -345,20 +385,83 @@ float AudioVisualizerEditor::getFrequencyValue(FrequencyRange range,
         case FrequencyRange::VeryHighs:     return audioProcessor.getVeryHighEnergy(panel);
         case FrequencyRange::KickTransient: return audioProcessor.getKickTransient(panel);
         case FrequencyRange::FullSpectrum:  return audioProcessor.getFullSpectrum(panel);
+        case FrequencyRange::SpectralCentroid: return audioProcessor.getSpectralCentroid(panel);
+        case FrequencyRange::SpectralSpread:   return audioProcessor.getSpectralSpread(panel);
+        case FrequencyRange::SpectralFlatness: return audioProcessor.getSpectralFlatness(panel);
+        case FrequencyRange::SpectralRolloff:  return audioProcessor.getSpectralRolloff(panel);
+        case FrequencyRange::SpectralFlux:     return audioProcessor.getSpectralFlux(panel);
+        case FrequencyRange::Pitch:
+            return normalisePitch(audioProcessor.getPitchHz(panel))
+                 * pitchGate(audioProcessor.getPitchConfidence(panel));
+        case FrequencyRange::StereoWidth:
+            return audioProcessor.getStereoWidth(panel, (int)FrequencyRange::FullSpectrum);
+        case FrequencyRange::StereoPan:
+            return 0.5f + 0.5f * audioProcessor.getStereoPan(panel, (int)FrequencyRange::FullSpectrum);
+        case FrequencyRange::StereoCorrelation:
+            return 0.5f + 0.5f * audioProcessor.getStereoCorrelation(panel, (int)FrequencyRange::FullSpectrum);
         default: return 0.0f;
     }
 }
 
+float AudioVisualizerEditor::getColourDriver(ColourSource source,
+                                               AudioVisualizerProcessor::PanelID panel)
+{
+    switch (source)
+    {
+        case ColourSource::Brightness: return audioProcessor.getSpectralCentroid(panel);
+        case ColourSource::PitchClass:
+        {
+            // Walk the circle of fifths so related keys get neighbouring hues
+            int pc = audioProcessor.getDominantPitchClass(panel);
+            return pc < 0 ? -1.0f : (float)((pc * 7) % 12) / 12.0f;
+        }
+        case ColourSource::Pitch:
+        {
+            // One hue turn per octave, so glides sweep smoothly through the wheel
+            if (audioProcessor.getPitchConfidence(panel) < 0.5f) return -1.0f;
+            float note = 12.0f * std::log2(std::max(audioProcessor.getPitchHz(panel), 1.0f) / 440.0f);
+            float turn = note / 12.0f;
+            return turn - std::floor(turn);
+        }
+        case ColourSource::Fixed:
+        default:                       return 0.0f;
+    }
+}
+
+juce::Colour AudioVisualizerEditor::panelColour(const Panel& p) const
+{
+    const auto base = p.config.effectColor;
+    const float v   = p.colourValue;
+
+    switch (p.config.colourSource)
+    {
+        case ColourSource::Brightness:
+            // Dull sounds pull the colour darker and warmer, bright ones lighter and cooler
+            return base.withRotatedHue((v - 0.5f) * 0.3f)
+                       .withMultipliedBrightness(0.45f + 0.55f * v);
+        case ColourSource::PitchClass:
+        case ColourSource::Pitch:
+        {
+            // Hue follows the harmony / melody; saturation/brightness come from the picked colour
+            float sat = base.getSaturation() < 0.2f ? 0.8f : base.getSaturation();
+            return juce::Colour::fromHSV(v, sat, base.getBrightness(), base.getFloatAlpha());
+        }
+        case ColourSource::Fixed:
+        default:
+            return base;
+    }
+}
+
 // =============================================================================
 // Rendering
 // =============================================================================
 
-void AudioVisualizerEditor::renderFrequencyLine(juce::Graphics& g, Panel& p)
+// Frequency span shown by the spectrum effects for a panel's range
+static void spectrumLimits(FrequencyRange range, float& minFreq, float& maxFreq)
 {
-    auto& b = p.bounds;
-
-    float minFreq = 20.0f, maxFreq = 20000.0f;
-    switch (p.config.frequencyRange)
+    minFreq = 20.0f;
+    maxFreq = 20000.0f;
+    switch (range)
     {
         case FrequencyRange::SubBass:       minFreq = 20.0f;   maxFreq = 60.0f;    break;
         case FrequencyRange::Bass:          minFreq = 60.0f;   maxFreq = 250.0f;   break;
@@ -369,136 +472,284 @@ void AudioVisualizerEditor::renderFrequencyLine(juce::Graphics& g, Panel& p)
         case FrequencyRange::VeryHighs:     minFreq = 8000.0f; maxFreq = 20000.0f; break;
         case FrequencyRange::KickTransient: minFreq = 50.0f;   maxFreq = 90.0f;    break;
         case FrequencyRange::FullSpectrum:  minFreq = 20.0f;   maxFreq = 20000.0f; break;
+        default:                            break;   // descriptors show the full spectrum
     }
+}
+
+void AudioVisualizerEditor::renderFrequencyLine(const juce::Image::BitmapData& pixels,
+                                                Panel& p, const PanelFrame& f)
+{
+    auto& b = f.bounds;
 
-    std::vector<float> spectrum;
-    audioProcessor.getSpectrumForRange(minFreq, maxFreq, spectrum, 50, p.procID);
+    float minFreq, maxFreq;
+    spectrumLimits(f.config.frequencyRange, minFreq, maxFreq);
+
+    // One point per few physical pixels, so a large panel shows as much detail as it has room for
+    const int numPoints = juce::jlimit(minLinePoints, maxLinePoints,
+                                       juce::roundToInt((float)b.getWidth() * f.scale / linePixelsPerPoint));
+
+    // Each panel owns the resonator bank at its index, used for ranges the FFT can't resolve
+    auto& spectrum = p.spectrumRaw;
+    audioProcessor.getDetailedSpectrumForRange(f.resonatorSlot, p.spectrumResampler, minFreq, maxFreq,
+                                               spectrum, numPoints, f.procID);
     if (spectrum.size() < 2) return;
+    const int n = (int)spectrum.size();
 
     if (p.spectrumSmooth.size() != spectrum.size())
         p.spectrumSmooth = spectrum;
 
     // Spatial smoothing (window = 2)
-    std::vector<float> spatial(spectrum.size());
-    for (int i = 0; i < (int)spectrum.size(); ++i)
+    float* spatial = p.frameArena.allocate<float>((size_t)n);
+    for (int i = 0; i < n; ++i)
     {
         float sum = 0.0f; int count = 0;
         for (int j = -2; j <= 2; ++j)
         {
             int idx = i + j;
-            if (idx >= 0 && idx < (int)spectrum.size())
-                { sum += spectrum[idx]; ++count; }
+            if (idx >= 0 && idx < n)
+                { sum += spectrum[(size_t)idx]; ++count; }
         }
         spatial[i] = sum / count;
     }
 
-    // Temporal smoothing (96% previous, 4% new)
-    std::vector<float> smoothed(spectrum.size());
-    for (int i = 0; i < (int)spectrum.size(); ++i)
+    // Temporal smoothing (96% previous, 4% new per 60 Hz frame)
+    const float keep = perFrame(0.96f, f.dt);
+    float* smoothed = p.frameArena.allocate<float>((size_t)n);
+    float largestStep = 0.0f;
+    for (int i = 0; i < n; ++i)
     {
-        smoothed[i] = p.spectrumSmooth[i] * 0.96f + spatial[i] * 0.04f;
-        p.spectrumSmooth[i] = smoothed[i];
+        smoothed[i] = p.spectrumSmooth[(size_t)i] * keep + spatial[i] * (1.0f - keep);
+        largestStep = std::max(largestStep, std::abs(smoothed[i] - p.spectrumSmooth[(size_t)i]));
+        p.spectrumSmooth[(size_t)i] = smoothed[i];
     }
 
     // Kick transient modulation
-    if (p.config.frequencyRange == FrequencyRange::KickTransient)
+    if (f.config.frequencyRange == FrequencyRange::KickTransient)
     {
-        float kv = audioProcessor.getKickTransient(p.procID);
-        for (auto& v : smoothed) v *= kv;
+        float kv = audioProcessor.getKickTransient(f.procID);
+        for (int i = 0; i < n; ++i) smoothed[i] *= kv;
     }
 
     // Adaptive normalization
     float currentPeak = 0.0001f;
-    for (float v : smoothed) if (v > currentPeak) currentPeak = v;
+    for (int i = 0; i < n; ++i) currentPeak = std::max(currentPeak, smoothed[i]);
 
-    if (currentPeak > p.spectrumPeak)
-        p.spectrumPeak = p.spectrumPeak * 0.3f + currentPeak * 0.7f;
-    else
-        p.spectrumPeak = p.spectrumPeak * 0.92f + currentPeak * 0.08f;
+    const float previousPeak = p.spectrumPeak;
+    const float peakKeep = perFrame(currentPeak > p.spectrumPeak ? 0.3f : 0.92f, f.dt);
+    p.spectrumPeak = p.spectrumPeak * peakKeep + currentPeak * (1.0f - peakKeep);
 
     static constexpr float amplitudeGain = 1.5f;
     float normFactor = p.spectrumPeak * amplitudeGain;
-    for (auto& v : smoothed) v /= normFactor;
-
-    // Build cubic path
-    juce::Path path;
-    float xScale = (float)b.getWidth() / (float)(smoothed.size() - 1);
 
-    auto clampY = [&](float v) {
-        return juce::jlimit((float)b.getY(), (float)b.getBottom(),
-                            b.getBottom() - v * amplitudeGain * b.getHeight());
-    };
-
-    path.startNewSubPath((float)b.getX(), clampY(smoothed[0]));
-
-    for (int i = 1; i < (int)smoothed.size(); ++i)
-    {
-        float x     = b.getX() + i * xScale;
-        float y     = clampY(smoothed[i]);
-        float prevX = b.getX() + (i - 1) * xScale;
-        float prevY = clampY(smoothed[i - 1]);
-
-        path.cubicTo(prevX + (x - prevX) * 0.25f, prevY,
-                     prevX + (x - prevX) * 0.75f, y,
-                     x, y);
-    }
-
-    g.setColour(p.config.effectColor);
-    g.strokePath(path, juce::PathStrokeType(1.15f,
-        juce::PathStrokeType::curved,
-        juce::PathStrokeType::rounded));
+    // Once a paused spectrum no longer moves on screen the governor stops repainting it
+    p.spectrumSettled = largestStep / normFactor < dirtyEpsilon
+                     && std::abs(p.spectrumPeak - previousPeak) / normFactor < dirtyEpsilon;
+    for (int i = 0; i < n; ++i) smoothed[i] /= normFactor;
+
+    // Curve in bitmap pixels. The raster smooths it with a Catmull-Rom spline and
+    // draws it column by column, so the cost follows the width, not the point count
+    const float xScale = (float)b.getWidth() * f.scale / (float)(n - 1);
+    const float height = (float)b.getHeight() * f.scale;
+
+    float* ys = p.frameArena.allocate<float>((size_t)n);
+    for (int i = 0; i < n; ++i)
+        ys[i] = juce::jlimit(0.0f, height, height - smoothed[i] * amplitudeGain * height);
+
+    SoftwareRaster::TraceStyle style;
+    style.lineWidth  = 1.15f * f.scale;
+    style.line       = f.colour;
+    style.fillBelow  = f.config.fillUnderLine;
+    style.fillTop    = f.colour.withMultipliedAlpha(0.45f);
+    style.fillBottom = f.colour.withMultipliedAlpha(0.05f);
+
+    float* scratch = p.frameArena.allocate<float>((size_t)SoftwareRaster::traceScratchSize(pixels.width));
+    SoftwareRaster(pixels).trace(ys, n, 0.0f, xScale, style, scratch);
 }
 
-void AudioVisualizerEditor::renderPanel(juce::Graphics& g, Panel& p, float rawValue)
+void AudioVisualizerEditor::renderPanel(juce::Image& image, Panel& p, const PanelFrame& f)
 {
-    auto& b = p.bounds;
-    auto  t = p.config.type;
+    auto& b  = f.bounds;
+    auto  t  = f.config.type;
+    auto  bg = f.background;
+    auto  colour = f.colour;
 
-    // Effective background: apply-all override → per-panel override → light/dark default
-    juce::Colour bg;
-    if (bgColorApplyAll)
-        bg = selectedBgColor;
-    else if (p.hasBgOverride)
-        bg = p.bgColor;
-    else
-        bg = lightMode ? juce::Colours::white : juce::Colours::black;
+    // Everything draws straight into the bitmap. No Graphics context means no
+    // renderer state to build, so a steady-state frame doesn't allocate
+    juce::Image::BitmapData pixels(image, juce::Image::BitmapData::readWrite);
+    const SoftwareRaster raster(pixels);
 
     if (t == EffectType::Flutter)
     {
-        g.setColour(bg.interpolatedWith(p.config.effectColor, p.smoothedValue));
-        g.fillRect(b);
+        raster.fill(bg.interpolatedWith(colour, f.value).getPixelARGB());
     }
     else if (t == EffectType::BinaryFlash)
     {
-        bool flash = p.smoothedValue > 0.3f;
-        g.setColour(flash ? p.config.effectColor : bg);
-        g.fillRect(b);
+        bool flash = f.value > 0.3f;
+        raster.fill((flash ? colour : bg).getPixelARGB());
     }
     else if (t == EffectType::Starfield)
     {
-        g.setColour(bg);
-        g.fillRect(b);
-        bool binaryMode = (p.config.frequencyRange == FrequencyRange::KickTransient);
+        raster.fill(bg.getPixelARGB());
+        bool binaryMode = (f.config.frequencyRange == FrequencyRange::KickTransient);
         float cx = b.getX() + b.getWidth()  * 0.5f;
         float cy = b.getY() + b.getHeight() * 0.5f;
-        p.starfield.update(rawValue, binaryMode);
-        p.starfield.draw(g, b, cx, cy, lightMode, p.config.effectColor);
+        if (f.config.followStereoPan)
+            cx += f.panValue * b.getWidth() * 0.35f;
+        p.starfield.setStarCount(StarfieldInstance::starCountFor(b, f.config.starDensity));
+        p.starfield.update(f.value, binaryMode, f.dt);
+        p.starfield.draw(pixels, f.scale, b, cx, cy, f.lightMode, colour);
     }
     else if (t == EffectType::RotatingCube)
     {
-        g.setColour(bg);
-        g.fillRect(b);
-        p.cube.update(rawValue);
-        p.cube.draw(g, b, lightMode, p.config.effectColor);
+        raster.fill(bg.getPixelARGB());
+        p.cube.update(f.value, f.dt);
+        p.cube.draw(pixels, f.scale, f.lightMode, colour, f.mesh.get());
+    }
+    else if (t == EffectType::SpectrumBars3D)
+    {
+        raster.fill(bg.getPixelARGB());
+
+        float minFreq, maxFreq;
+        spectrumLimits(f.config.frequencyRange, minFreq, maxFreq);
+        audioProcessor.getDetailedSpectrumForRange(f.resonatorSlot, p.bars.resampler, minFreq, maxFreq,
+                                                   p.bars.spectrum,
+                                                   SpectrumBarsInstance::numBands * SpectrumBarsInstance::pointsPerBand,
+                                                   f.procID);
+        p.bars.update(f.value, f.dt);
+        p.bars.draw(pixels, f.lightMode, colour);
     }
     else if (t == EffectType::FrequencyLine)
     {
-        g.setColour(bg);
-        g.fillRect(b);
-        renderFrequencyLine(g, p);
+        raster.fill(bg.getPixelARGB());
+        renderFrequencyLine(pixels, p, f);
     }
 }
 
+AudioVisualizerEditor::PanelFrame
+AudioVisualizerEditor::capturePanelFrame(const Panel& p, int slot, float dt) const
+{
+    PanelFrame f;
+    f.config        = p.config;
+    f.bounds        = p.bounds;
+    f.procID        = p.procID;
+    f.resonatorSlot = slot;
+    f.value         = p.smoothedValue;
+    f.panValue      = p.panValue;
+    f.dt            = dt;
+    f.scale         = juce::Component::getApproximateScaleFactorForComponent(this);
+    f.colour        = panelColour(p);
+    f.lightMode     = lightMode;
+    f.mesh          = p.mesh;
+    f.stateKey      = p.paintedKey;
+
+    // Effective background: apply-all override → per-panel override → light/dark default
+    if (bgColorApplyAll)
+        f.background = selectedBgColor;
+    else if (p.hasBgOverride)
+        f.background = p.bgColor;
+    else
+        f.background = lightMode ? juce::Colours::white : juce::Colours::black;
+
+    return f;
+}
+
+void AudioVisualizerEditor::dispatchPanelRender(Panel& p, const PanelFrame& frame)
+{
+    if (p.renderJob == nullptr)
+        p.renderJob = std::make_unique<PanelRenderJob>(*this, p);
+
+    // The job is idle (isRenderQueued was false), so its frame is ours to write
+    p.renderJob->frame = frame;
+    renderPool.addJob(p.renderJob.get(), false);
+}
+
+bool AudioVisualizerEditor::isRenderQueued(const Panel& p) const
+{
+    return p.renderJob != nullptr && renderPool.contains(p.renderJob.get());
+}
+
+void AudioVisualizerEditor::waitForPanelRenders() const
+{
+    for (auto& panel : panels)
+        if (panel->renderJob != nullptr)
+            renderPool.waitForJobToFinish(panel->renderJob.get(), -1);
+}
+
+juce::ThreadPoolJob::JobStatus AudioVisualizerEditor::PanelRenderJob::runJob()
+{
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    auto& p = panel;
+
+    // The front image may be on screen right now; only the back one is ours
+    const int back = p.frontImage.load() == 0 ? 1 : 0;
+    const int w = juce::jmax(1, juce::roundToInt((float)frame.bounds.getWidth()  * frame.scale));
+    const int h = juce::jmax(1, juce::roundToInt((float)frame.bounds.getHeight() * frame.scale));
+
+    auto& image = p.images[back];
+    if (image.getWidth() != w || image.getHeight() != h)
+        image = juce::Image(juce::Image::RGB, w, h, false, juce::SoftwareImageType());
+
+    // Buffers resize when the layout or settings change; once they've been the
+    // same for a while, a frame that still allocates is a bug
+    const bool sameAsLast = frame.stateKey == p.renderedKey && frame.scale == p.renderedScale;
+    p.steadyFrames  = sameAsLast ? p.steadyFrames + 1 : 0;
+    p.renderedKey   = frame.stateKey;
+    p.renderedScale = frame.scale;
+    p.frameArena.reset();
+
+    {
+        AllocationCounter::ExpectNone noAllocations(p.steadyFrames > steadyFramesBeforeCheck);
+        editor.renderPanel(image, p, frame);
+    }
+
+    p.renderCostMs = (float)(juce::Time::getMillisecondCounterHiRes() - startMs);
+    p.frontImage   = back;
+    p.renderedNew  = true;
+    return jobHasFinished;
+}
+
+void AudioVisualizerEditor::loadPanelMesh(int panelId, const juce::File& file)
+{
+    auto* p = findPanel(panelId);
+    if (!p) return;
+
+    p->config.meshFile = file.getFullPathName();
+
+    juce::Component::SafePointer<AudioVisualizerEditor> editor(this);
+    meshLoadPool.addJob([editor, panelId, file]
+    {
+        juce::String error;
+        auto mesh = MeshImporter::load(file, error);
+
+        juce::MessageManager::callAsync([editor, panelId, path = file.getFullPathName(), mesh, error]
+        {
+            if (editor != nullptr)
+                editor->meshLoaded(panelId, path, mesh, error);
+        });
+    });
+}
+
+void AudioVisualizerEditor::meshLoaded(int panelId, const juce::String& path,
+                                       std::shared_ptr<const ImportedMesh> mesh,
+                                       const juce::String& error)
+{
+    // Closed, or another mesh (or the cube) picked while this one loaded
+    auto* p = findPanel(panelId);
+    if (!p || p->config.meshFile != path) return;
+
+    if (mesh == nullptr)
+    {
+        p->config.meshFile.clear();
+        p->mesh.reset();
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon,
+                                               "Couldn't import mesh", error);
+        return;
+    }
+
+    // Render jobs hold their own reference, so swapping it here is safe
+    p->mesh = std::move(mesh);
+}
+
 // =============================================================================
 // paint()
 // =============================================================================
@@ -515,34 +766,34 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
     // Compute panel bounds from layout tree
     computeBounds(layoutRoot.get(), vizBounds);
 
-    bool isPlaying = audioProcessor.isPlaying();
+    const double paintStartMs = juce::Time::getMillisecondCounterHiRes();
+    lastPaintMs = paintStartMs;
 
     // -------------------------------------------------------------------------
-    // Render each panel
+    // Composite each panel's latest rendered image
     // -------------------------------------------------------------------------
     for (auto& panel : panels)
     {
-        if (panel->bounds.isEmpty()) continue;
-
-        float rawValue = getFrequencyValue(panel->config.frequencyRange, panel->procID);
+        if (panel->bounds.isEmpty() || !g.clipRegionIntersects(panel->bounds)) continue;
 
-        if (isPlaying)
-            panel->smoothedValue = panel->smoothedValue * visualSmoothingFactor
-                                 + rawValue * (1.0f - visualSmoothingFactor);
+        // Everything here stays inside the panel's bounds, so there's no clip
+        // region to save and restore (which would allocate on every paint)
+        const int front = panel->frontImage.load();
+        if (front >= 0)
+        {
+            g.drawImage(panel->images[front], panel->bounds.toFloat());
+        }
         else
-            panel->smoothedValue *= pauseFadeFactor;
-
         {
-            juce::Graphics::ScopedSaveState clip(g);
-            g.reduceClipRegion(panel->bounds);
-            renderPanel(g, *panel, panel->smoothedValue);
+            g.setColour(lightMode ? juce::Colours::white : juce::Colours::black);
+            g.fillRect(panel->bounds);
+        }
 
-            // Effect-drop hover highlight
-            if (isDraggingEffect && panel->id == effectHoverPanelId)
-            {
-                g.setColour(juce::Colour(0, 122, 255).withAlpha(0.8f));
-                g.drawRect(panel->bounds.toFloat(), 4.0f);
-            }
+        // Effect-drop hover highlight
+        if (isDraggingEffect && panel->id == effectHoverPanelId)
+        {
+            g.setColour(juce::Colour(0, 122, 255).withAlpha(0.8f));
+            g.drawRect(panel->bounds.toFloat(), 4.0f);
         }
 
         // Subtle border between panels
@@ -552,6 +803,19 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
         g.drawRect(panel->bounds.toFloat(), 1.0f);
     }
 
+    // Resonator banks only serve visible spectrum panels; free the rest. A slot
+    // whose render job is still queued may be mid-request, so it waits a frame
+    for (int slot = 0; slot < AudioVisualizerProcessor::maxResonatorBanks; ++slot)
+    {
+        bool inUse = slot < (int)panels.size()
+                  && (isRenderQueued(*panels[(size_t)slot])
+                   || ((panels[(size_t)slot]->config.type == EffectType::FrequencyLine
+                     || panels[(size_t)slot]->config.type == EffectType::SpectrumBars3D)
+                    && !panels[(size_t)slot]->bounds.isEmpty()));
+        if (!inUse)
+            audioProcessor.releaseResonatorBank(slot);
+    }
+
     // -------------------------------------------------------------------------
     // Panel drag overlay
     // -------------------------------------------------------------------------
@@ -692,19 +956,19 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
         effectListAreaH = listArea.getHeight();
 
         static constexpr int kRowH = 36;
-        int totalListH  = 5 * kRowH;
+        int totalListH  = numPickerEffects * kRowH;
         int maxScroll   = std::max(0, totalListH - effectListAreaH);
         effectListScrollOffset = juce::jlimit(0, maxScroll, effectListScrollOffset);
 
         static const char* kEffectNames[] = {
-            "Binary Flash", "Flutter", "Starfield", "Spectrum", "3D Cube"
+            "Binary Flash", "Flutter", "Starfield", "Spectrum", "3D Cube", "3D Bars"
         };
 
         {
             juce::Graphics::ScopedSaveState listClip(g);
             g.reduceClipRegion(listArea);
 
-            for (int i = 0; i < 5; i++)
+            for (int i = 0; i < numPickerEffects; i++)
             {
                 int itemY = listArea.getY() + i * kRowH - effectListScrollOffset;
                 auto row  = juce::Rectangle<int>(listArea.getX(), itemY,
@@ -729,7 +993,7 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
                         g.fillEllipse(hdx + col * 5.0f - 2.5f,
                                       hdy + r2 * 4.0f - 1.0f, 2.0f, 2.0f);
 
-                if (i < 4)
+                if (i < numPickerEffects - 1)
                 {
                     g.setColour(rowDiv);
                     g.fillRect(row.getX() + 18, row.getBottom(), row.getWidth() - 18, 1);
@@ -823,7 +1087,7 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
                             || audioProcessor.isAudioLoaded());
     if (shouldShowDebug)
     {
-        auto getFreqName = [](FrequencyRange r) -> juce::String {
+        auto getFreqName = [](FrequencyRange r) -> const char* {
             switch (r) {
                 case FrequencyRange::SubBass:       return "Sub-Bass";
                 case FrequencyRange::Bass:          return "Bass";
@@ -834,6 +1098,15 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
                 case FrequencyRange::VeryHighs:     return "Very Highs";
                 case FrequencyRange::KickTransient: return "Kick";
                 case FrequencyRange::FullSpectrum:  return "Full";
+                case FrequencyRange::SpectralCentroid: return "Brightness";
+                case FrequencyRange::SpectralSpread:   return "Spread";
+                case FrequencyRange::SpectralFlatness: return "Noisiness";
+                case FrequencyRange::SpectralRolloff:  return "Rolloff";
+                case FrequencyRange::SpectralFlux:     return "Flux";
+                case FrequencyRange::Pitch:            return "Pitch";
+                case FrequencyRange::StereoWidth:      return "Width";
+                case FrequencyRange::StereoPan:        return "Pan";
+                case FrequencyRange::StereoCorrelation: return "Correlation";
                 default:                            return "?";
             }
         };
@@ -841,15 +1114,49 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
         auto textCol = lightMode ? juce::Colours::black.withAlpha(0.8f)
                                  : juce::Colours::white.withAlpha(0.8f);
         g.setColour(textCol);
-        g.setFont(12.0f);
 
+        const double nowMs = juce::Time::getMillisecondCounterHiRes();
         for (auto& panel : panels)
         {
-            float raw = getFrequencyValue(panel->config.frequencyRange, panel->procID);
-            juce::String txt = getFreqName(panel->config.frequencyRange)
-                             + ": " + juce::String(raw, 2);
-            g.drawText(txt, panel->bounds.reduced(10).removeFromTop(20),
-                       juce::Justification::topLeft);
+            float raw = getFrequencyValue(panel->config.frequencyRange, panel->procID,
+                                          panel->config.component);
+
+            // Laid out again only when the text would read differently (while
+            // playing no faster than anyone can read it) or the panel's width
+            // changed; drawing the cached glyphs doesn't allocate
+            const auto area = panel->bounds.reduced(10);
+            const auto key  = ((juce::int64)panel->config.frequencyRange << 32)
+                            | (juce::uint32)juce::roundToInt(raw * 100.0f);
+            const bool rangeChanged = (key >> 32) != (panel->debugTextKey >> 32);
+            if (area.getWidth() != panel->debugTextWidth
+             || (key != panel->debugTextKey && (rangeChanged || nowMs - panel->debugTextMs >= debugTextIntervalMs)))
+            {
+                const juce::Font font(12.0f);
+                panel->debugText.clear();
+                panel->debugText.addCurtailedLineOfText(font, juce::String(getFreqName(panel->config.frequencyRange))
+                                                                  + ": " + juce::String(raw, 2),
+                                                        0.0f, font.getAscent(), (float)area.getWidth(), true);
+                panel->debugTextKey   = key;
+                panel->debugTextWidth = area.getWidth();
+                panel->debugTextMs    = nowMs;
+            }
+            panel->debugText.draw(g, juce::AffineTransform::translation((float)area.getX(), (float)area.getY()));
+        }
+
+        // Standalone read-ahead health and pre-analysis progress
+        if (audioProcessor.wrapperType == juce::AudioProcessor::wrapperType_Standalone)
+        {
+            auto statusArea = vizBounds.reduced(10);
+            g.setFont(12.0f);
+
+            if (audioProcessor.getPlaybackUnderruns() > 0)
+                g.drawText("Playback underruns: " + juce::String(audioProcessor.getPlaybackUnderruns()),
+                           statusArea.removeFromBottom(20), juce::Justification::bottomLeft);
+
+            float analysed = audioProcessor.getPreAnalysisProgress();
+            if (analysed >= 0.0f && analysed < 1.0f)
+                g.drawText("Pre-analysis: " + juce::String(juce::roundToInt(analysed * 100.0f)) + "%",
+                           statusArea.removeFromBottom(20), juce::Justification::bottomLeft);
         }
     }
 
@@ -857,12 +1164,23 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
     // Standalone loading overlay
     // -------------------------------------------------------------------------
     if (audioProcessor.wrapperType == juce::AudioProcessor::wrapperType_Standalone &&
-        (!audioProcessor.isAudioLoaded() || showLoadedMessage))
+        (!audioProcessor.isAudioLoaded() || showLoadedMessage || waitingForLoad))
     {
         g.setColour(juce::Colours::white);
         g.setFont(16.0f);
 
-        if (showLoadedMessage)
+        if (waitingForLoad)
+        {
+            // Progress bar under the status line; the panels keep animating behind it
+            auto centre = getLocalBounds().getCentre();
+            auto track  = juce::Rectangle<float>(240.0f, 4.0f).withCentre(centre.toFloat().translated(0.0f, 24.0f));
+            g.drawText(statusMessage, getLocalBounds(), juce::Justification::centred);
+            g.setColour(juce::Colours::white.withAlpha(0.25f));
+            g.fillRoundedRectangle(track, 2.0f);
+            g.setColour(juce::Colours::white);
+            g.fillRoundedRectangle(track.withWidth(track.getWidth() * audioProcessor.getLoadProgress()), 2.0f);
+        }
+        else if (showLoadedMessage)
         {
             g.drawText("Audio loaded! Press SPACE to play",
                        getLocalBounds(), juce::Justification::centred);
@@ -878,6 +1196,9 @@ void AudioVisualizerEditor::paint (juce::Graphics& g)
                        instrArea, juce::Justification::centredBottom);
         }
     }
+
+    // Feeds the vblank divider
+    paintCostMs = paintCostMs * 0.9 + (juce::Time::getMillisecondCounterHiRes() - paintStartMs) * 0.1;
 }
 
 void AudioVisualizerEditor::resized()
@@ -1172,7 +1493,7 @@ void AudioVisualizerEditor::mouseDrag(const juce::MouseEvent& event)
     // --- Effect picker drag (drag effect onto panel) ---
     if (!pdActive && effectPickerVisible)
     {
-        for (int i = 0; i < 5; i++)
+        for (int i = 0; i < numPickerEffects; i++)
         {
             if (effectBoxBounds[i].contains(pos))
             {
@@ -1184,6 +1505,7 @@ void AudioVisualizerEditor::mouseDrag(const juce::MouseEvent& event)
                     case 2: effectType = EffectType::Starfield;     break;
                     case 3: effectType = EffectType::FrequencyLine; break;
                     case 4: effectType = EffectType::RotatingCube;  break;
+                    case 5: effectType = EffectType::SpectrumBars3D; break;
                     default: return;
                 }
 
@@ -1200,7 +1522,7 @@ void AudioVisualizerEditor::mouseDrag(const juce::MouseEvent& event)
                 dg.setColour(juce::Colours::white);
                 dg.setFont(14.0f);
                 static const char* kNames[] = {
-                    "Binary Flash","Flutter","Starfield","Spectrum","3D Cube"
+                    "Binary Flash","Flutter","Starfield","Spectrum","3D Cube","3D Bars"
                 };
                 dg.drawText(kNames[i], juce::Rectangle<int>(30, 0, 70, 40),
                             juce::Justification::centredLeft);
@@ -1220,11 +1542,45 @@ void AudioVisualizerEditor::mouseDrag(const juce::MouseEvent& event)
 }
 
 // =============================================================================
-// Timer
+// Frame pacing
 // =============================================================================
 
+void AudioVisualizerEditor::onVBlank()
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    if (lastVBlankMs > 0.0)
+        vblankIntervalMs = vblankIntervalMs * 0.9 + juce::jmin(now - lastVBlankMs, 100.0) * 0.1;
+    lastVBlankMs = now;
+
+    // Render every Nth vblank when a frame costs more than one refresh interval,
+    // so a slow machine settles at an even 30 / 36 / 48 fps instead of stuttering.
+    // Panels render in parallel, so the slowest one sets the cost
+    double frameCostMs = paintCostMs;
+    for (auto& panel : panels)
+        frameCostMs = std::max(frameCostMs, (double)panel->renderCostMs.load());
+
+    frameDivider = juce::jlimit(1, maxFrameDivider, (int)std::ceil(frameCostMs * 1.2 / vblankIntervalMs));
+    if (++vblanksSinceFrame < frameDivider)
+        return;
+
+    vblanksSinceFrame = 0;
+    advanceFrame(now);
+}
+
 void AudioVisualizerEditor::timerCallback()
 {
+    // Vblank callbacks stop when the window is hidden or the platform has no display
+    // link; keep the housekeeping (and a modest frame rate) going without them
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    if (now - lastVBlankMs > 250.0)
+        advanceFrame(now);
+}
+
+void AudioVisualizerEditor::advanceFrame(double nowMs)
+{
+    const float dt = (float)juce::jlimit(0.0, maxFrameDelta, (nowMs - lastFrameMs) / 1000.0);
+    lastFrameMs = nowMs;
+
     // Panel drag: activate after delay even if mouse hasn't moved
     if (pdDragId >= 0 && !pdActive)
     {
@@ -1254,11 +1610,268 @@ void AudioVisualizerEditor::timerCallback()
     // Loaded message countdown
     if (showLoadedMessage)
     {
-        if (--loadedMessageTimer <= 0)
+        loadedMessageTimer -= dt;
+        if (loadedMessageTimer <= 0.0f)
+        {
             showLoadedMessage = false;
+            repaint();
+        }
     }
 
-    repaint();
+    applySectionChanges();
+    applyMidiTriggers(dt);
+    checkLoadProgress();
+
+    updatePanelValues(dt);
+    repaintDirtyPanels(nowMs);
+}
+
+void AudioVisualizerEditor::updatePanelValues(float dt)
+{
+    const bool isPlaying = audioProcessor.isPlaying();
+    const float smoothing = perFrame(visualSmoothingFactor, dt);
+
+    for (auto& panel : panels)
+    {
+        if (panel->bounds.isEmpty()) continue;
+
+        float rawValue = getFrequencyValue(panel->config.frequencyRange, panel->procID,
+                                           panel->config.component);
+
+        if (isPlaying)
+            panel->smoothedValue = panel->smoothedValue * smoothing + rawValue * (1.0f - smoothing);
+        else
+            panel->smoothedValue *= perFrame(pauseFadeFactor, dt);
+
+        // MIDI bursts bypass the audio smoothing so they land on the cue
+        if (panel->config.respondToMidi)
+            panel->smoothedValue = std::max(panel->smoothedValue, panel->midiBurst);
+
+        if (panel->config.followStereoPan)
+        {
+            float pan = audioProcessor.getStereoPan(panel->procID, stereoBandFor(panel->config.frequencyRange));
+            const float drift = perFrame(0.9f, dt);   // slow drift, not a jitter
+            panel->panValue = panel->panValue * drift + pan * (1.0f - drift);
+        }
+
+        if (panel->config.colourSource != ColourSource::Fixed)
+        {
+            float driver = getColourDriver(panel->config.colourSource, panel->procID);
+            if (panel->config.colourSource == ColourSource::PitchClass
+             || panel->config.colourSource == ColourSource::Pitch)
+            {
+                // Hue wraps, so don't blend through unrelated colours; hold when unpitched
+                if (driver >= 0.0f)
+                    panel->colourValue = driver;
+            }
+            else
+            {
+                panel->colourValue = panel->colourValue * smoothing + driver * (1.0f - smoothing);
+            }
+        }
+    }
+}
+
+// Everything besides the audio values that changes what a panel looks like
+juce::int64 AudioVisualizerEditor::panelStateKey(const Panel& p) const
+{
+    auto bg = bgColorApplyAll ? selectedBgColor : (p.hasBgOverride ? p.bgColor : juce::Colour());
+
+    CacheStorage::Hash key;
+    auto mix = [&key](juce::int64 v) { key.add(v); };
+
+    mix((int)p.config.type);
+    mix((int)p.config.frequencyRange);
+    mix((int)p.config.colourSource);
+    mix(juce::roundToInt(p.config.starDensity * 100.0f));
+    mix((juce::int64)(juce::pointer_sized_int)p.mesh.get());
+    mix(p.config.fillUnderLine);
+    mix(p.config.effectColor.getARGB());
+    mix(bg.getARGB());
+    mix(lightMode);
+    mix(showDebugValues);
+    mix(isDraggingEffect && p.id == effectHoverPanelId);
+    mix(p.bounds.getX());
+    mix(p.bounds.getY());
+    mix(p.bounds.getWidth());
+    mix(p.bounds.getHeight());
+    return (juce::int64)key.value;
+}
+
+bool AudioVisualizerEditor::isPanelDirty(const Panel& p, bool isPlaying) const
+{
+    if (p.paintedKey != panelStateKey(p))
+        return true;
+
+    switch (p.config.type)
+    {
+        case EffectType::Flutter:
+            return std::abs(p.smoothedValue - p.paintedValue) > dirtyEpsilon
+                || std::abs(p.colourValue - p.paintedColour) > dirtyEpsilon;
+
+        case EffectType::BinaryFlash:
+            return (p.smoothedValue > 0.3f) != (p.paintedValue > 0.3f)
+                || std::abs(p.colourValue - p.paintedColour) > dirtyEpsilon;
+
+        case EffectType::Starfield:
+        case EffectType::RotatingCube:
+        case EffectType::SpectrumBars3D:
+            // Animating while the music plays and until the value has faded out
+            return isPlaying || p.smoothedValue > dirtyEpsilon
+                || std::abs(p.colourValue - p.paintedColour) > dirtyEpsilon;
+
+        case EffectType::FrequencyLine:
+            return isPlaying || !p.spectrumSettled;
+
+        default:
+            return true;
+    }
+}
+
+void AudioVisualizerEditor::repaintDirtyPanels(double nowMs)
+{
+    // Minimised or closed: no frames at all
+    auto* peer = getPeer();
+    if (!isShowing() || peer == nullptr || peer->isMinimised())
+        return;
+
+    // Occluded: the OS stops painting us, so stop asking, apart from a rare probe
+    // repaint that brings the frames back as soon as a paint gets through again
+    const bool requestPending = lastRepaintRequestMs > lastPaintMs;
+    if (requestPending && nowMs - lastRepaintRequestMs > occlusionTimeoutMs)
+    {
+        if (nowMs - lastOcclusionProbeMs >= occlusionProbeMs)
+        {
+            lastOcclusionProbeMs = nowMs;
+            repaint();
+        }
+        return;
+    }
+
+    // Bounds from the current layout, so jobs render at the size they'll be shown at
+    auto vizBounds = getLocalBounds();
+    if (effectPickerVisible) vizBounds.removeFromRight(220);
+    computeBounds(layoutRoot.get(), vizBounds);
+
+    const bool isPlaying = audioProcessor.isPlaying();
+    bool anyFinished = false;
+
+    for (size_t slot = 0; slot < panels.size(); ++slot)
+    {
+        auto& panel = *panels[slot];
+
+        // Composite what finished since the last tick (a rendered frame shows one tick later)
+        if (panel.renderedNew.exchange(false))
+        {
+            repaint(panel.bounds);
+            anyFinished = true;
+        }
+
+        // A panel still rendering its previous frame just skips this one
+        if (panel.bounds.isEmpty() || isRenderQueued(panel) || !isPanelDirty(panel, isPlaying))
+            continue;
+
+        // Animation advances by the real time since this panel was last rendered
+        const float dt = (float)juce::jlimit(0.0, maxFrameDelta, (nowMs - panel.lastRenderMs) / 1000.0);
+        panel.lastRenderMs  = nowMs;
+        panel.paintedValue  = panel.smoothedValue;
+        panel.paintedColour = panel.colourValue;
+        panel.paintedKey    = panelStateKey(panel);
+
+        dispatchPanelRender(panel, capturePanelFrame(panel, (int)slot, dt));
+    }
+
+    // Overlays that animate by themselves cover several panels; the tick they
+    // stop on repaints once more so their last frame doesn't stay on screen
+    float analysed = audioProcessor.getPreAnalysisProgress();
+    const bool animating = waitingForLoad || pdActive || bgDragActive || isDraggingEffect
+                        || (showDebugValues && analysed >= 0.0f && analysed < 1.0f);
+    const bool overlayEnded = overlayAnimating && !animating;
+    overlayAnimating = animating;
+
+    if (animating || overlayEnded)
+    {
+        if (!requestPending)
+            lastRepaintRequestMs = nowMs;
+        repaint();
+        return;
+    }
+
+    // Idle: nothing changed, nothing painted
+    if (anyFinished && !requestPending)
+        lastRepaintRequestMs = nowMs;
+}
+
+void AudioVisualizerEditor::applyMidiTriggers(float dt)
+{
+    std::array<AudioVisualizerProcessor::MidiTrigger, 64> incoming;
+    int count;
+    while ((count = audioProcessor.popMidiTriggers(incoming.data(), (int)incoming.size())) > 0)
+        pendingMidiTriggers.insert(pendingMidiTriggers.end(), incoming.begin(), incoming.begin() + count);
+
+    for (auto& panel : panels)
+        panel->midiBurst *= perFrame(0.8f, dt);
+
+    // Fire everything whose sample is being heard now
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    auto due = std::stable_partition(pendingMidiTriggers.begin(), pendingMidiTriggers.end(),
+                                     [now](const auto& t) { return t.presentationMs > now; });
+
+    for (auto it = due; it != pendingMidiTriggers.end(); ++it)
+    {
+        if (now - it->presentationMs > maxMidiTriggerLateMs)
+            continue;
+
+        for (auto& panel : panels)
+            if (panel->config.respondToMidi)
+                panel->midiBurst = std::max(panel->midiBurst, it->value);
+    }
+
+    pendingMidiTriggers.erase(due, pendingMidiTriggers.end());
+}
+
+void AudioVisualizerEditor::applySectionChanges()
+{
+    for (auto& panel : panels)
+    {
+        // Each bus counts on its own. When the sidechain comes or goes the panel
+        // reads a different counter, so that's a new baseline, not a section change
+        const auto bus = audioProcessor.hasSidechainInput(panel->procID) ? panel->procID
+                                                                         : AudioVisualizerProcessor::Main;
+        int count = audioProcessor.getBusSectionChangeCount(bus);
+        bool changed = panel->lastSectionBus == (int)bus && count != panel->lastSectionCount;
+        panel->lastSectionCount = count;
+        panel->lastSectionBus   = (int)bus;
+
+        if (!changed) continue;
+
+        switch (panel->config.onSectionChange)
+        {
+            case SectionAction::NextEffect:
+            {
+                constexpr int numEffectTypes = (int)EffectType::SpectrumBars3D + 1;
+                auto next = (EffectType)(((int)panel->config.type + 1) % numEffectTypes);
+                applyEffectToPanel(panel->id, next, panel->config.effectColor);
+                break;
+            }
+            case SectionAction::NextColour:
+            {
+                // A golden-ratio step never lands near a recent hue. Grey has no hue
+                // to rotate (the default white included), so it starts at a
+                // saturated one, different per panel
+                auto& colour = panel->config.effectColor;
+                if (colour.getSaturation() < 0.05f)
+                    colour = juce::Colour::fromHSV(std::fmod(0.382f * (float)(panel->id + 1), 1.0f), 0.8f,
+                                                   juce::jmax(0.5f, colour.getBrightness()), colour.getFloatAlpha());
+                else
+                    colour = colour.withRotatedHue(0.382f);
+                break;
+            }
+            case SectionAction::None:
+            default:
+                break;
+        }
+    }
 }
 
 // =============================================================================
@@ -1335,6 +1948,8 @@ void AudioVisualizerEditor::saveStateToProcessor()
     xml->setAttribute("selectedColor",   selectedColor.toString());
     xml->setAttribute("selectedBgColor", selectedBgColor.toString());
     xml->setAttribute("bgColorApplyAll", bgColorApplyAll);
+    xml->setAttribute("midiOutput",      audioProcessor.isMidiOutputEnabled());
+    xml->setAttribute("preAnalyse",      audioProcessor.isPreAnalysisEnabled());
 
     auto* panelsEl = xml->createNewChildElement("Panels");
     for (auto& p : panels)
@@ -1344,6 +1959,14 @@ void AudioVisualizerEditor::saveStateToProcessor()
         e->setAttribute("effectType",   (int)p->config.type);
         e->setAttribute("freqRange",    (int)p->config.frequencyRange);
         e->setAttribute("effectColor",  p->config.effectColor.toString());
+        e->setAttribute("colourSource", (int)p->config.colourSource);
+        e->setAttribute("followPan",    p->config.followStereoPan);
+        e->setAttribute("starDensity",  p->config.starDensity);
+        e->setAttribute("mesh",         p->config.meshFile);
+        e->setAttribute("lineFill",     p->config.fillUnderLine);
+        e->setAttribute("component",    (int)p->config.component);
+        e->setAttribute("onSection",    (int)p->config.onSectionChange);
+        e->setAttribute("midiTrigger",  p->config.respondToMidi);
         e->setAttribute("procID",       (int)p->procID);
         e->setAttribute("bgColor",      p->bgColor.toString());
         e->setAttribute("hasBgOverride", p->hasBgOverride);
@@ -1375,6 +1998,7 @@ bool AudioVisualizerEditor::loadStateFromProcessor()
     bgColorApplyAll = xml->getBoolAttribute("bgColorApplyAll", false);
 
     // Restore panels
+    waitForPanelRenders();
     panels.clear();
     nextPanelId = 0;
     auto* panelsEl = xml->getChildByName("Panels");
@@ -1387,9 +2011,18 @@ bool AudioVisualizerEditor::loadStateFromProcessor()
         panel->config.type           = (EffectType)e->getIntAttribute("effectType", (int)EffectType::Flutter);
         panel->config.frequencyRange = (FrequencyRange)e->getIntAttribute("freqRange", (int)FrequencyRange::Mids);
         panel->config.effectColor    = juce::Colour::fromString(e->getStringAttribute("effectColor", "ffffffff"));
+        panel->config.colourSource   = (ColourSource)e->getIntAttribute("colourSource", (int)ColourSource::Fixed);
+        panel->config.followStereoPan = e->getBoolAttribute("followPan", false);
+        panel->config.component      = (SignalComponent)e->getIntAttribute("component", (int)SignalComponent::Mixed);
+        panel->config.onSectionChange = (SectionAction)e->getIntAttribute("onSection", (int)SectionAction::None);
+        panel->config.respondToMidi  = e->getBoolAttribute("midiTrigger", false);
         panel->procID                = (AudioVisualizerProcessor::PanelID)e->getIntAttribute("procID", (int)AudioVisualizerProcessor::Main);
         panel->bgColor               = juce::Colour::fromString(e->getStringAttribute("bgColor", "ff000000"));
         panel->hasBgOverride         = e->getBoolAttribute("hasBgOverride", false);
+        panel->config.starDensity    = (float)e->getDoubleAttribute("starDensity", 1.0);
+        panel->config.meshFile       = e->getStringAttribute("mesh");
+        panel->config.fillUnderLine  = e->getBoolAttribute("lineFill", false);
+        panel->starfield.seed        = (juce::uint64)panel->id + 1;
         nextPanelId = std::max(nextPanelId, panel->id + 1);
         panels.push_back(std::move(panel));
     }
@@ -1406,9 +2039,17 @@ bool AudioVisualizerEditor::loadStateFromProcessor()
         return false;
     }
 
+    for (auto& p : panels)
+        if (p->config.meshFile.isNotEmpty())
+            loadPanelMesh(p->id, juce::File(p->config.meshFile));
+
     return true;
 }
 
+// Star Density menu choices (multipliers of StarfieldInstance::starsPerMegapixel)
+static const float kStarDensities[]    = { 0.5f, 1.0f, 2.0f, 4.0f };
+static const char* kStarDensityNames[] = { "Sparse", "Normal", "Dense", "Very Dense" };
+
 void AudioVisualizerEditor::showPanelMenu(int panelId)
 {
     auto* panel = findPanel(panelId);
@@ -1428,9 +2069,70 @@ void AudioVisualizerEditor::showPanelMenu(int panelId)
     menu.addItem(7, "Very Highs (8000-20000 Hz)",true, currentRange == FrequencyRange::VeryHighs);
     menu.addItem(8, "Kick Transient (50-90 Hz)", true, currentRange == FrequencyRange::KickTransient);
     menu.addItem(9, "Full Spectrum",             true, currentRange == FrequencyRange::FullSpectrum);
+    menu.addItem(12, "Pitch (Vocal / Lead)",     true, currentRange == FrequencyRange::Pitch);
+
+    juce::PopupMenu descriptorMenu;
+    descriptorMenu.addItem(30, "Brightness (Centroid)", true, currentRange == FrequencyRange::SpectralCentroid);
+    descriptorMenu.addItem(31, "Spread",                true, currentRange == FrequencyRange::SpectralSpread);
+    descriptorMenu.addItem(32, "Noisiness (Flatness)",  true, currentRange == FrequencyRange::SpectralFlatness);
+    descriptorMenu.addItem(33, "Rolloff",               true, currentRange == FrequencyRange::SpectralRolloff);
+    descriptorMenu.addItem(34, "Flux",                  true, currentRange == FrequencyRange::SpectralFlux);
+    menu.addSubMenu("Spectral Descriptors", descriptorMenu);
+
+    juce::PopupMenu stereoMenu;
+    stereoMenu.addItem(35, "Width",       true, currentRange == FrequencyRange::StereoWidth);
+    stereoMenu.addItem(36, "Pan",         true, currentRange == FrequencyRange::StereoPan);
+    stereoMenu.addItem(37, "Correlation", true, currentRange == FrequencyRange::StereoCorrelation);
+    stereoMenu.addSeparator();
+    stereoMenu.addItem(38, "Starfield Centre Follows Pan",
+                       panel->config.type == EffectType::Starfield, panel->config.followStereoPan);
+    menu.addSubMenu("Stereo Field", stereoMenu);
+
+    auto currentColour = panel->config.colourSource;
+    juce::PopupMenu colourMenu;
+    colourMenu.addItem(40, "Fixed",             true, currentColour == ColourSource::Fixed);
+    colourMenu.addItem(41, "Follow Brightness", true, currentColour == ColourSource::Brightness);
+    colourMenu.addItem(42, "Follow Harmony",    true, currentColour == ColourSource::PitchClass);
+    colourMenu.addItem(43, "Follow Pitch",      true, currentColour == ColourSource::Pitch);
+    menu.addSubMenu("Colour", colourMenu);
+
+    // Harmonic/percussive split applies to the plain bands only
+    auto currentComponent = panel->config.component;
+    bool isBand = (int)currentRange <= (int)FrequencyRange::FullSpectrum;
+    juce::PopupMenu componentMenu;
+    componentMenu.addItem(50, "Mixed",               isBand, currentComponent == SignalComponent::Mixed);
+    componentMenu.addItem(51, "Harmonic (Tonal)",    isBand, currentComponent == SignalComponent::Harmonic);
+    componentMenu.addItem(52, "Percussive (Drums)",  isBand, currentComponent == SignalComponent::Percussive);
+    menu.addSubMenu("Component", componentMenu);
+
+    auto currentSectionAction = panel->config.onSectionChange;
+    juce::PopupMenu sectionMenu;
+    sectionMenu.addItem(60, "Do Nothing",  true, currentSectionAction == SectionAction::None);
+    sectionMenu.addItem(61, "Next Effect", true, currentSectionAction == SectionAction::NextEffect);
+    sectionMenu.addItem(62, "Next Colour", true, currentSectionAction == SectionAction::NextColour);
+    menu.addSubMenu("On Section Change", sectionMenu);
+
+    juce::PopupMenu densityMenu;
+    bool isStarfield = panel->config.type == EffectType::Starfield;
+    for (int i = 0; i < 4; ++i)
+        densityMenu.addItem(80 + i, kStarDensityNames[i], isStarfield,
+                            panel->config.starDensity == kStarDensities[i]);
+    menu.addSubMenu("Star Density", densityMenu);
+
+    juce::PopupMenu meshMenu;
+    bool isCube = panel->config.type == EffectType::RotatingCube;
+    meshMenu.addItem(90, "Load Mesh (OBJ / PLY)...", isCube);
+    meshMenu.addItem(91, "Cube", isCube, panel->config.meshFile.isEmpty());
+    menu.addSubMenu("3D Mesh", meshMenu);
+    menu.addItem(92, "Fill Under Line", panel->config.type == EffectType::FrequencyLine,
+                 panel->config.fillUnderLine);
+    menu.addItem(70, "Respond to MIDI", true, panel->config.respondToMidi);
 
     menu.addSeparator();
     menu.addItem(10, "Show Values", true, showDebugValues);
+    menu.addItem(71, "Send MIDI (Onsets + Band CCs)", true, audioProcessor.isMidiOutputEnabled());
+    if (audioProcessor.wrapperType == juce::AudioProcessor::wrapperType_Standalone)
+        menu.addItem(72, "Pre-analyse Loaded Files", true, audioProcessor.isPreAnalysisEnabled());
 
     menu.addSeparator();
     menu.addItem(11, hasSidechain ? "Input: Sidechain" : "Input: Main Track", false, false);
@@ -1467,6 +2169,80 @@ void AudioVisualizerEditor::showPanelMenu(int panelId)
             return;
         }
 
+        if (result == 38)
+        {
+            p->config.followStereoPan = !p->config.followStereoPan;
+            p->panValue = 0.0f;
+            return;
+        }
+        if (result >= 40 && result <= 43)
+        {
+            p->config.colourSource = (ColourSource)(result - 40);
+            p->colourValue = 0.0f;
+            return;
+        }
+        if (result >= 50 && result <= 52)
+        {
+            p->config.component = (SignalComponent)(result - 50);
+            return;
+        }
+        if (result >= 60 && result <= 62)
+        {
+            p->config.onSectionChange = (SectionAction)(result - 60);
+            return;
+        }
+        if (result == 71)
+        {
+            audioProcessor.setMidiOutputEnabled(!audioProcessor.isMidiOutputEnabled());
+            saveStateToProcessor();
+            return;
+        }
+        if (result == 72)
+        {
+            audioProcessor.setPreAnalysisEnabled(!audioProcessor.isPreAnalysisEnabled());
+            saveStateToProcessor();
+            return;
+        }
+        if (result >= 80 && result <= 83)
+        {
+            p->config.starDensity = kStarDensities[result - 80];
+            return;
+        }
+        if (result == 90)
+        {
+            auto chooser = std::make_shared<juce::FileChooser>(
+                "Select a mesh to display...",
+                juce::File::getSpecialLocation(juce::File::userDocumentsDirectory),
+                "*.obj;*.ply");
+
+            chooser->launchAsync(
+                juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                [this, chooser, panelId](const juce::FileChooser& fc)
+                {
+                    auto file = fc.getResult();
+                    if (file != juce::File())
+                        loadPanelMesh(panelId, file);
+                });
+            return;
+        }
+        if (result == 91)
+        {
+            p->config.meshFile.clear();
+            p->mesh.reset();
+            return;
+        }
+        if (result == 92)
+        {
+            p->config.fillUnderLine = !p->config.fillUnderLine;
+            return;
+        }
+        if (result == 70)
+        {
+            p->config.respondToMidi = !p->config.respondToMidi;
+            p->midiBurst = 0.0f;
+            return;
+        }
+
         FrequencyRange range;
         switch (result)
         {
@@ -1479,8 +2255,18 @@ void AudioVisualizerEditor::showPanelMenu(int panelId)
             case 7: range = FrequencyRange::VeryHighs;     break;
             case 8: range = FrequencyRange::KickTransient; break;
             case 9: range = FrequencyRange::FullSpectrum;  break;
+            case 12: range = FrequencyRange::Pitch;            break;
+            case 30: range = FrequencyRange::SpectralCentroid; break;
+            case 31: range = FrequencyRange::SpectralSpread;   break;
+            case 32: range = FrequencyRange::SpectralFlatness; break;
+            case 33: range = FrequencyRange::SpectralRolloff;  break;
+            case 34: range = FrequencyRange::SpectralFlux;     break;
+            case 35: range = FrequencyRange::StereoWidth;      break;
+            case 36: range = FrequencyRange::StereoPan;        break;
+            case 37: range = FrequencyRange::StereoCorrelation; break;
             default: return;
         }
+        waitForPanelRenders();
         p->config.frequencyRange = range;
         p->spectrumSmooth.clear();  // reset spectrum buffer on range change
     });
@@ -1495,7 +2281,10 @@ void AudioVisualizerEditor::applyEffectToPanel(int panelId, EffectType effect,
     p->config.type        = effect;
     p->config.effectColor = color;
     if (effect == EffectType::Starfield)
+    {
+        waitForPanelRenders();
         p->starfield.initStars();
+    }
 
     repaint();
 }
@@ -1576,7 +2365,7 @@ void AudioVisualizerEditor::mouseWheelMove(const juce::MouseEvent& event,
 
     effectListScrollOffset -= (int)(wheel.deltaY * 60.0f);
 
-    int maxScroll = std::max(0, 5 * 36 - effectListAreaH);
+    int maxScroll = std::max(0, numPickerEffects * 36 - effectListAreaH);
     effectListScrollOffset = juce::jlimit(0, maxScroll, effectListScrollOffset);
 
     repaint();
@@ -1612,20 +2401,7 @@ bool AudioVisualizerEditor::keyPressed (const juce::KeyPress& key)
             {
                 auto file = fc.getResult();
                 if (file != juce::File())
-                {
-                    audioProcessor.loadAudioFile(file);
-                    if (audioProcessor.isAudioLoaded())
-                    {
-                        showLoadedMessage = true;
-                        loadedMessageTimer = 120;
-                        statusMessage = "Audio loaded: " + file.getFileName();
-                    }
-                    else
-                    {
-                        statusMessage = "Failed to load audio file";
-                    }
-                    repaint();
-                }
+                    startLoading(file);
             });
         return true;
     }
@@ -1640,7 +2416,9 @@ bool AudioVisualizerEditor::keyPressed (const juce::KeyPress& key)
 bool AudioVisualizerEditor::isInterestedInFileDrag (const juce::StringArray& files)
 {
     for (const auto& f : files)
-        if (f.endsWithIgnoreCase(".wav")  || f.endsWithIgnoreCase(".aif")  ||
+        if (juce::File(f).isDirectory()       ||   // a folder becomes a playlist
+            MeshImporter::canImport(juce::File(f)) ||   // a mesh goes to the panel under the cursor
+            f.endsWithIgnoreCase(".wav")  || f.endsWithIgnoreCase(".aif")  ||
             f.endsWithIgnoreCase(".aiff") || f.endsWithIgnoreCase(".mp3")  ||
             f.endsWithIgnoreCase(".flac") || f.endsWithIgnoreCase(".ogg")  ||
             f.endsWithIgnoreCase(".m4a"))
@@ -1650,20 +2428,90 @@ bool AudioVisualizerEditor::isInterestedInFileDrag (const juce::StringArray& fil
 
 void AudioVisualizerEditor::filesDropped (const juce::StringArray& files, int x, int y)
 {
-    juce::ignoreUnused(x, y);
-    if (files.size() > 0)
+    // Folders expand to their audio files, in name order
+    juce::Array<juce::File> tracks;
+    for (const auto& path : files)
     {
-        audioProcessor.loadAudioFile(juce::File(files[0]));
-        if (audioProcessor.isAudioLoaded())
+        juce::File f(path);
+        if (MeshImporter::canImport(f))
         {
-            showLoadedMessage  = true;
-            loadedMessageTimer = 120;
-            statusMessage = "Audio loaded: " + juce::File(files[0]).getFileName();
+            // Turns the panel it lands on into the 3D mesh effect
+            int targetId = panelAtPos({ x, y });
+            if (auto* p = findPanel(targetId))
+            {
+                if (p->config.type != EffectType::RotatingCube)
+                    applyEffectToPanel(targetId, EffectType::RotatingCube, p->config.effectColor);
+                loadPanelMesh(targetId, f);
+            }
         }
-        else
+        else if (f.isDirectory())
         {
-            statusMessage = "Failed to load audio file";
+            auto contents = f.findChildFiles(juce::File::findFiles, false,
+                                             "*.wav;*.aiff;*.aif;*.mp3;*.flac;*.ogg;*.m4a");
+            contents.sort();
+            tracks.addArray(contents);
         }
-        repaint();
+        else if (isInterestedInFileDrag(juce::StringArray(path)))
+        {
+            tracks.add(f);
+        }
+    }
+
+    if (tracks.size() == 1 && !juce::File(files[0]).isDirectory())
+        startLoading(tracks.getFirst());
+    else if (!tracks.isEmpty())
+        startPlaylist(tracks);
+}
+
+void AudioVisualizerEditor::startLoading(const juce::File& file)
+{
+    // Returns immediately; timerCallback picks up the result while the visuals keep running
+    audioProcessor.loadAudioFile(file);
+    loadingFileName   = file.getFileName();
+    waitingForLoad    = true;
+    showLoadedMessage = false;
+    statusMessage     = "Loading " + loadingFileName + "...";
+    repaint();
+}
+
+void AudioVisualizerEditor::startPlaylist(const juce::Array<juce::File>& tracks)
+{
+    // Playlists loop (unattended installations); shift-drop starts every track
+    // with fresh normalization instead of carrying the levels over
+    const auto policy = juce::ModifierKeys::getCurrentModifiers().isShiftDown()
+                          ? AudioVisualizerProcessor::NormalisationPolicy::Reset
+                          : AudioVisualizerProcessor::NormalisationPolicy::CarryOver;
+
+    audioProcessor.setPlaylist(tracks, true, policy);
+    loadingFileName   = juce::String(tracks.size()) + " tracks";
+    waitingForLoad    = true;
+    showLoadedMessage = false;
+    statusMessage     = "Loading playlist (" + loadingFileName + ")...";
+    repaint();
+}
+
+void AudioVisualizerEditor::checkLoadProgress()
+{
+    if (!waitingForLoad)
+        return;
+
+    switch (audioProcessor.getLoadState())
+    {
+        case AudioVisualizerProcessor::LoadState::Ready:
+            waitingForLoad     = false;
+            showLoadedMessage  = true;
+            loadedMessageTimer = 2.0f;
+            statusMessage = "Audio loaded: " + loadingFileName;
+            repaint();
+            break;
+        case AudioVisualizerProcessor::LoadState::Failed:
+            waitingForLoad = false;
+            statusMessage  = "Failed to load audio file";
+            repaint();
+            break;
+        case AudioVisualizerProcessor::LoadState::Loading:
+        case AudioVisualizerProcessor::LoadState::Idle:
+        default:
+            break;
     }
 }
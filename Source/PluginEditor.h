@@ -4,6 +4,10 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "PluginProcessor.h"
 #include "EffectSystem.h"
+#include "Render3D.h"
+#include "MeshImport.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
 
 class AudioVisualizerEditor : public juce::AudioProcessorEditor,
                                public juce::FileDragAndDropTarget,
@@ -25,7 +29,7 @@ public:
     // Keyboard handling
     bool keyPressed (const juce::KeyPress& key) override;
 
-    // Timer for animation
+    // Fallback frame tick for when vblank callbacks stop (minimised, no display link)
     void timerCallback() override;
 
     // Mouse handling
@@ -41,11 +45,54 @@ public:
     void itemDropped(const juce::DragAndDropTarget::SourceDetails& details) override;
 
 private:
+    friend class FrameAllocationTest;   // Tests/FrameAllocationTests.cpp drives the render job directly
+
     AudioVisualizerProcessor& audioProcessor;
 
-    bool showLoadedMessage = false;
-    int  loadedMessageTimer = 0;
+    bool  showLoadedMessage = false;
+    float loadedMessageTimer = 0.0f;   // seconds left
     juce::String statusMessage = "Drop audio file here or press 'O' to open";
+    juce::String loadingFileName;
+    bool waitingForLoad = false;
+
+    void startLoading(const juce::File& file);
+    void startPlaylist(const juce::Array<juce::File>& tracks);
+    void checkLoadProgress();
+
+    // Frame pacing: frames are driven by the display's vblank, skipping vblanks when
+    // painting can't keep up, and every animation advances by elapsed time
+    void onVBlank();
+    void advanceFrame(double nowMs);
+    void updatePanelValues(float dt);
+
+    // Render governor: each tick re-renders only the panels whose picture would change
+    // (a value moved by more than dirtyEpsilon, a running animation, a config change),
+    // and nothing at all while idle, minimised or occluded
+    static constexpr float  dirtyEpsilon       = 1.0f / 512.0f;
+    static constexpr double occlusionTimeoutMs = 500.0;    // repaints asked for but never painted
+    static constexpr double occlusionProbeMs   = 1000.0;
+    double lastRepaintRequestMs = 0.0;                     // oldest request not yet painted
+    double lastOcclusionProbeMs = 0.0;
+    bool   overlayAnimating = false;                       // last tick's overlays, so their end is painted too
+    struct Panel;
+    juce::int64 panelStateKey(const Panel& p) const;
+    bool isPanelDirty(const Panel& p, bool isPlaying) const;
+    void repaintDirtyPanels(double nowMs);
+    static constexpr int    maxFrameDivider    = 4;      // 144 Hz display -> down to 36 fps
+    static constexpr double maxFrameDelta      = 0.1;    // seconds; longer gaps don't jump the animation
+    static constexpr int    fallbackTimerHz    = 30;
+    double lastVBlankMs     = 0.0;
+    double lastFrameMs      = 0.0;
+    double lastPaintMs      = 0.0;
+    double vblankIntervalMs = 1000.0 / 60.0;             // smoothed
+    double paintCostMs      = 0.0;                       // smoothed
+    int    vblanksSinceFrame = 0;
+    int    frameDivider      = 1;
+
+    // The per-frame factors below were tuned at this rate; perFrame() converts
+    // one into the factor for a frame of dt seconds
+    static constexpr float referenceFrameRate = 60.0f;
+    static float perFrame(float factor, float dt) { return std::pow(factor, dt * referenceFrameRate); }
 
     static constexpr float visualSmoothingFactor = 0.7f;
     static constexpr float pauseFadeFactor       = 0.98f;
@@ -53,55 +100,180 @@ private:
     // -------------------------------------------------------------------------
     // Effect instances (implementations in separate .cpp files)
     // -------------------------------------------------------------------------
-    struct Star { float x, y, z, prevX, prevY, prevZ; };
-
     struct StarfieldInstance {
-        std::vector<Star> stars;
+        // Structure of arrays so the per-frame loops vectorise; the count follows
+        // the panel's area (setStarCount), so small panels stay cheap
+        std::vector<float> starX, starY, starZ;
         float currentSpeed = 2.0f;
-        juce::Random random;
-        StarfieldInstance() { stars.reserve(200); initStars(); }
-        void initStars();
-        void update(float value, bool isBinaryMode);
-        void draw(juce::Graphics& g, const juce::Rectangle<int>& bounds,
+        juce::uint64 seed = 1, counter = 0;                      // respawn RNG state
+
+        static constexpr float starsPerMegapixel = 1600.0f;      // ~200 on a 400 x 300 panel at density 1
+        static constexpr int   minStars = 64, maxStars = 32768;
+        static int starCountFor(const juce::Rectangle<int>& bounds, float density);
+
+        void initStars();                                        // restart the field from the seed
+        void setStarCount(int count);
+        void update(float value, bool isBinaryMode, float dt);
+        // Rasterises straight into the panel bitmap (pixelScale pixels per point)
+        void draw(const juce::Image::BitmapData& pixels, float pixelScale,
+                  const juce::Rectangle<int>& bounds,
                   float cx, float cy, bool lightMode, juce::Colour color);
+        std::vector<float> projectedX, projectedY;               // draw() scratch
+
+    private:
+        float nextRandom();
+        void  spawn(size_t i, float z);
     };
 
     struct RotatingCubeInstance {
         float rotX = 0.0f, rotY = 0.0f, rotZ = 0.0f;
         float speedX = 0.4f, speedY = 0.7f, speedZ = 0.2f;
         float scale  = 1.0f;
-        void update(float value);
-        void draw(juce::Graphics& g, const juce::Rectangle<int>& bounds,
-                  bool lightMode, juce::Colour color);
+        Render3D renderer;
+        void update(float value, float dt);
+        // mesh: an imported model drawn in place of the cube, or null
+        void draw(const juce::Image::BitmapData& pixels, float pixelScale,
+                  bool lightMode, juce::Colour color, const ImportedMesh* mesh);
+    };
+
+    // Grid of 3D bars: one column per band, rows behind the front one are its history
+    struct SpectrumBarsInstance {
+        static constexpr int   numBands = 16, numRows = 8;     // 128 boxes
+        static constexpr int   pointsPerBand = 4;
+        static constexpr float rowsPerSecond = 12.0f;
+        std::array<float, numBands * numRows> heights {};      // 0..1, row 0 = newest
+        std::vector<float> spectrum;                           // filled by the caller before update()
+        SpectrumResampler  resampler { SpectrumResampler::Aggregate::Rms };
+        float peak     = 0.0001f;
+        float yaw      = 0.0f;
+        float rowTimer = 0.0f;
+        Render3D renderer;
+        void update(float value, float dt);
+        void draw(const juce::Image::BitmapData& pixels, bool lightMode, juce::Colour color);
     };
 
     // -------------------------------------------------------------------------
     // Panel — all per-panel audio + visual state
     // -------------------------------------------------------------------------
+    struct PanelRenderJob;
+
     struct Panel {
         int id = -1;
         EffectConfig config;
         StarfieldInstance starfield;
         RotatingCubeInstance cube;
+        SpectrumBarsInstance bars;
         float smoothedValue = 0.0f;
+        float colourValue   = 0.0f;                              // smoothed colour driver
+        float panValue      = 0.0f;                              // smoothed stereo pan, -1..1
+        int   lastSectionCount = -1;                             // processor counter last acted on
+        int   lastSectionBus   = -1;                             // the bus that counter belongs to
+        float midiBurst     = 0.0f;                              // latest MIDI trigger level, decays per tick
         float spectrumPeak  = 0.0001f;
-        std::vector<float> spectrumSmooth;
+        std::vector<float> spectrumRaw, spectrumSmooth;
+        SpectrumResampler  spectrumResampler;                    // frequency line, peak per column
+        std::atomic<bool> spectrumSettled { false };             // smoothing has converged (governor)
+        double      lastRenderMs  = 0.0;                         // governor bookkeeping: what was last drawn
+        float       paintedValue  = -1.0f;
+        float       paintedColour = -1.0f;
+        juce::int64 paintedKey    = 0;
         juce::Rectangle<int> bounds;                             // updated each frame
         AudioVisualizerProcessor::PanelID procID = AudioVisualizerProcessor::Main;
         juce::Colour bgColor       = juce::Colours::black;
         bool         hasBgOverride = false;
+        std::shared_ptr<const ImportedMesh> mesh;                // loaded config.meshFile, null until ready
+        juce::GlyphArrangement debugText;                        // value overlay, laid out at the origin when it changes
+        juce::int64  debugTextKey   = -1;
+        int          debugTextWidth = -1;                        // curtailed to this
+        double       debugTextMs    = 0.0;                       // when it was last rebuilt
+
+        // Double buffer: a render job draws into the back image and then flips
+        // frontImage; paint() only ever reads the front one. While the job is
+        // queued (isRenderQueued) it owns the back image and the effect state
+        std::unique_ptr<PanelRenderJob> renderJob;               // created on first dispatch, then reused
+        juce::Image        images[2];
+        std::atomic<int>   frontImage  { -1 };                   // -1 = nothing rendered yet
+        std::atomic<bool>  renderedNew { false };                // flipped, not yet repainted
+        std::atomic<float> renderCostMs { 0.0f };
+
+        // Render job only
+        FrameArena  frameArena;                                  // per-frame scratch
+        juce::int64 renderedKey   = 0;
+        float       renderedScale = 0.0f;
+        int         steadyFrames  = 0;                           // frames since the key or scale changed
+    };
+
+    // Everything a render job reads, captured on the message thread when it's queued
+    struct PanelFrame {
+        EffectConfig config;
+        juce::Rectangle<int> bounds;
+        AudioVisualizerProcessor::PanelID procID = AudioVisualizerProcessor::Main;
+        int   resonatorSlot = 0;
+        float value    = 0.0f;
+        float panValue = 0.0f;
+        float dt       = 0.0f;
+        float scale    = 1.0f;                                   // physical pixels per point
+        juce::Colour background, colour;
+        bool  lightMode = false;
+        std::shared_ptr<const ImportedMesh> mesh;                // kept alive for the job
+        juce::int64 stateKey = 0;                                // panelStateKey when captured
+    };
+
+    // One per panel, re-queued for every frame, so dispatching allocates nothing
+    struct PanelRenderJob : public juce::ThreadPoolJob {
+        PanelRenderJob(AudioVisualizerEditor& e, Panel& p)
+            : juce::ThreadPoolJob("Panel render"), editor(e), panel(p) {}
+
+        JobStatus runJob() override;
+
+        AudioVisualizerEditor& editor;
+        Panel&     panel;
+        PanelFrame frame;                                        // set by dispatchPanelRender while idle
     };
 
+    // Debug builds assert that a frame whose key hasn't changed for this many
+    // frames makes no heap allocations (see AllocationCounter)
+    static constexpr int steadyFramesBeforeCheck = 30;
+    static constexpr double debugTextIntervalMs  = 100.0;       // value overlay refresh while the value moves
+
     std::vector<std::unique_ptr<Panel>> panels;
     int nextPanelId = 0;
 
+    // Panels render in parallel here, one job per panel at a time
+    juce::ThreadPool renderPool { juce::jlimit(1, 4, juce::SystemStats::getNumCpus() - 1) };
+
+    PanelFrame capturePanelFrame(const Panel& p, int slot, float dt) const;
+    void dispatchPanelRender(Panel& p, const PanelFrame& frame);
+    bool isRenderQueued(const Panel& p) const;
+    void waitForPanelRenders() const;   // before touching effect state or removing panels
+
+    // Mesh import runs here (it can take seconds for a big scan); the result comes
+    // back on the message thread and is dropped if the panel moved on meanwhile
+    juce::ThreadPool meshLoadPool { 1 };
+    void loadPanelMesh(int panelId, const juce::File& file);
+    void meshLoaded(int panelId, const juce::String& path,
+                    std::shared_ptr<const ImportedMesh> mesh, const juce::String& error);
+
     Panel* findPanel(int id) const;
     int    panelAtPos(juce::Point<int> pos) const;
     int    createPanel(EffectConfig cfg, AudioVisualizerProcessor::PanelID procID);
 
-    void renderPanel(juce::Graphics& g, Panel& p, float rawValue);
-    void renderFrequencyLine(juce::Graphics& g, Panel& p);
-    float getFrequencyValue(FrequencyRange range, AudioVisualizerProcessor::PanelID panel);
+    void renderPanel(juce::Image& image, Panel& p, const PanelFrame& f);
+    void renderFrequencyLine(const juce::Image::BitmapData& pixels, Panel& p, const PanelFrame& f);
+    static constexpr float linePixelsPerPoint = 3.0f;            // physical pixels per frequency line point
+    static constexpr int   minLinePoints = 16, maxLinePoints = 640;
+    float getFrequencyValue(FrequencyRange range, AudioVisualizerProcessor::PanelID panel,
+                            SignalComponent component = SignalComponent::Mixed);
+    float getColourDriver(ColourSource source, AudioVisualizerProcessor::PanelID panel);
+    juce::Colour panelColour(const Panel& p) const;
+    void applySectionChanges();
+    void applyMidiTriggers(float dt);
+
+    // MIDI triggers received but not yet due (presentation time in the future)
+    std::vector<AudioVisualizerProcessor::MidiTrigger> pendingMidiTriggers;
+    // Triggers due longer ago than this are dropped, not fired: they queued up
+    // while the editor was closed or stalled and would all land in one burst
+    static constexpr double maxMidiTriggerLateMs = 50.0;
 
     // -------------------------------------------------------------------------
     // Binary split tree — defines panel layout
@@ -184,7 +356,8 @@ private:
     bool isDraggingEffect   = false;
     int  effectHoverPanelId = -1;
 
-    juce::Rectangle<int> effectBoxBounds[5];
+    static constexpr int numPickerEffects = 6;
+    juce::Rectangle<int> effectBoxBounds[numPickerEffects];
     juce::Rectangle<int> lightModeToggleBounds;
     juce::Rectangle<int> colorPickerBounds;
 
@@ -216,5 +389,8 @@ private:
     void serializeLayout   (const LayoutNode* node, juce::XmlElement* parent) const;
     std::unique_ptr<LayoutNode> deserializeLayout (const juce::XmlElement* xml);
 
+    // Last member: starts calling back once everything above is constructed
+    juce::VBlankAttachment vblankAttachment { this, [this] { onVBlank(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioVisualizerEditor)
 };
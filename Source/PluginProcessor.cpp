@@ -10,14 +10,27 @@ AudioVisualizerProcessor::AudioVisualizerProcessor()
                      .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
 {
     formatManager.registerBasicFormats();
+    readAheadThread.startThread();
     fftData.fill(0.0f);
     topFftData.fill(0.0f);
     bottomLeftFftData.fill(0.0f);
     bottomRightFftData.fill(0.0f);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(windowTable.data(), fftSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
 }
 
 AudioVisualizerProcessor::~AudioVisualizerProcessor()
 {
+    // Finish any load, then free every track before the read-ahead thread goes away
+    stopTimer();
+    loaderPool.removeAllJobs(true, 5000);
+    analysisPool.removeAllJobs(true, 5000);
+    releaseRetiredTracks();
+    delete incomingTrack.exchange(nullptr);
+    delete queuedTrack.exchange(nullptr);
+    delete currentTrack;
+    currentTrack = nullptr;
+    readAheadThread.stopThread(2000);
 }
 
 const juce::String AudioVisualizerProcessor::getName() const
@@ -27,12 +40,12 @@ const juce::String AudioVisualizerProcessor::getName() const
 
 bool AudioVisualizerProcessor::acceptsMidi() const
 {
-    return false;
+    return true;   // notes / CCs trigger visual events
 }
 
 bool AudioVisualizerProcessor::producesMidi() const
 {
-    return false;
+    return true;   // onset notes + band CCs, when enabled
 }
 
 bool AudioVisualizerProcessor::isMidiEffect() const
@@ -73,12 +86,25 @@ void AudioVisualizerProcessor::changeProgramName (int index, const juce::String&
 
 void AudioVisualizerProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    transportSource.prepareToPlay(samplesPerBlock, sampleRate);
+    preparedBlockSize.store(samplesPerBlock);
+    preparedSampleRate.store(sampleRate);
+    playbackResampler.prepareToPlay(samplesPerBlock, sampleRate);
+    if (currentTrack != nullptr)
+        playbackResampler.setResamplingRatio(currentTrack->fileSampleRate / sampleRate);
+
+    chromaMap.prepare(sampleRate);
+    melMap.prepare(sampleRate);
+
+    bandCcSent.fill(-1);   // resend every CC after a restart
+
+    // Float copy of the inputs for double-precision hosts
+    analysisConversionBuffer.setSize(juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()),
+                                     samplesPerBlock);
 }
 
 void AudioVisualizerProcessor::releaseResources()
 {
-    transportSource.releaseResources();
+    playbackResampler.releaseResources();
 }
 
 bool AudioVisualizerProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -97,10 +123,8 @@ bool AudioVisualizerProcessor::isBusesLayoutSupported (const BusesLayout& layout
     return true;
 }
 
-void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void AudioVisualizerProcessor::updateHostTransportState()
 {
-    juce::ignoreUnused (midiMessages);
-
     // Update DAW transport state so isPlaying() reflects reality in VST3/AU
     if (wrapperType != wrapperType_Standalone)
     {
@@ -110,6 +134,85 @@ void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
                 hostIsPlaying = pos->getIsPlaying();
         dacPlaying.store(hostIsPlaying);
     }
+}
+
+void AudioVisualizerProcessor::queueMidiTriggers(const juce::MidiBuffer& midiMessages, int numSamples)
+{
+    if (midiMessages.isEmpty()) return;
+
+    // This block is heard roughly one block from now; each event lands at its
+    // own sample offset within it
+    const double sampleRate  = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    const double msPerSample = 1000.0 / sampleRate;
+    const double blockDueMs  = juce::Time::getMillisecondCounterHiRes()
+                             + (numSamples + getLatencySamples()) * msPerSample;
+
+    for (const auto metadata : midiMessages)
+    {
+        const auto msg = metadata.getMessage();
+
+        MidiTrigger trigger;
+        trigger.presentationMs = blockDueMs + metadata.samplePosition * msPerSample;
+        trigger.channel        = msg.getChannel();
+
+        if (msg.isNoteOn())
+        {
+            trigger.number = msg.getNoteNumber();
+            trigger.value  = msg.getFloatVelocity();
+        }
+        else if (msg.isController() && msg.getControllerValue() > 0)
+        {
+            trigger.number       = msg.getControllerNumber();
+            trigger.value        = (float)msg.getControllerValue() / 127.0f;
+            trigger.isController = true;
+        }
+        else
+        {
+            continue;
+        }
+
+        // Drop rather than block when the editor isn't draining (closed / stalled)
+        const auto scope = midiTriggerFifo.write(1);
+        if (scope.blockSize1 > 0)
+            midiTriggerQueue[(size_t)scope.startIndex1] = trigger;
+    }
+}
+
+int AudioVisualizerProcessor::popMidiTriggers(MidiTrigger* dest, int maxTriggers)
+{
+    const auto scope = midiTriggerFifo.read(juce::jmin(maxTriggers, midiTriggerFifo.getNumReady()));
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        dest[i] = midiTriggerQueue[(size_t)(scope.startIndex1 + i)];
+    for (int i = 0; i < scope.blockSize2; ++i)
+        dest[scope.blockSize1 + i] = midiTriggerQueue[(size_t)(scope.startIndex2 + i)];
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+// Mix sidechain audio into the main output so it's audible (only buses carrying signal)
+template <typename SampleType>
+void AudioVisualizerProcessor::mixSidechainsIntoMain(juce::AudioBuffer<SampleType>& buffer)
+{
+    for (int busIndex = Top; busIndex <= BottomRight; ++busIndex)
+    {
+        auto bus = getBusBuffer(buffer, true, busIndex);
+        if (bus.getNumChannels() == 0 || bus.getNumSamples() == 0)
+            continue;
+
+        if (bus.getMagnitude(0, bus.getNumSamples()) > (SampleType)0.0001)
+        {
+            for (int ch = 0; ch < juce::jmin(bus.getNumChannels(), 2); ++ch)
+                buffer.addFrom(ch, 0, bus, ch, 0, bus.getNumSamples());
+        }
+    }
+}
+
+void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    updateHostTransportState();
+    queueMidiTriggers(midiMessages, buffer.getNumSamples());
+    midiMessages.clear();   // input is only cues; the output carries our own notes and CCs alone
 
     // Runtime check: use loaded audio only for Standalone builds
     bool usingLoadedAudio = (wrapperType == wrapperType_Standalone);
@@ -118,188 +221,298 @@ void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     {
         // Standalone: Clear buffer and use loaded audio file
         buffer.clear();
+        swapInIncomingTrack();
 
-        if (audioLoaded && playing)
+        if (currentTrack != nullptr && playing)
         {
             juce::AudioSourceChannelInfo channelInfo(buffer);
-            transportSource.getNextAudioBlock(channelInfo);
+            playbackResampler.getNextAudioBlock(channelInfo);
         }
+
+        auto* features = currentTrack != nullptr ? currentTrack->features.get() : nullptr;
+        preAnalysisProgress.store(features != nullptr && !features->failed.load() ? features->getProgress() : -1.0f);
     }
     // For VST3/AU: Don't clear buffer, audio passes through
 
     // Skip all analysis when the DAW (or standalone transport) is paused —
     // prevents adaptive normalization from drifting during silence
-    if (!isPlaying())
+    if (isPlaying())
+    {
+        analysisBlockOffset = 0;
+        analyseBlock(buffer, usingLoadedAudio);
+
+        if (!usingLoadedAudio)
+            mixSidechainsIntoMain(buffer);
+    }
+
+    writeMidiOutput(midiMessages, buffer.getNumSamples());
+}
+
+// Plain loop on purpose: compilers turn it into packed double -> float conversions
+static void convertToFloat(const double* source, float* dest, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] = (float)source[i];
+}
+
+void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // The standalone player (and loaded-file playback) always runs in float
+    jassert (wrapperType != wrapperType_Standalone);
+
+    updateHostTransportState();
+    queueMidiTriggers(midiMessages, buffer.getNumSamples());
+    midiMessages.clear();
+
+    // The host's double audio passes through untouched; the analysers read a
+    // float copy made in one pass per channel, in preallocated chunks
+    const int capacity    = analysisConversionBuffer.getNumSamples();
+    const int numChannels = juce::jmin(buffer.getNumChannels(), analysisConversionBuffer.getNumChannels());
+
+    if (isPlaying() && capacity > 0)
+    {
+        for (int start = 0; start < buffer.getNumSamples(); start += capacity)
+        {
+            int numSamples = juce::jmin(capacity, buffer.getNumSamples() - start);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                convertToFloat(buffer.getReadPointer(ch, start), analysisConversionBuffer.getWritePointer(ch), numSamples);
+
+            juce::AudioBuffer<float> chunk(analysisConversionBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+            analysisBlockOffset = start;
+            analyseBlock(chunk, false);
+        }
+
+        mixSidechainsIntoMain(buffer);
+    }
+
+    writeMidiOutput(midiMessages, buffer.getNumSamples());
+}
+
+void AudioVisualizerProcessor::queueOnsetNote(int noteIndex, int sampleInChunk)
+{
+    // First detection in the block wins; hops are far longer than any block
+    if (pendingNoteOnAt[(size_t)noteIndex] < 0)
+        pendingNoteOnAt[(size_t)noteIndex] = analysisBlockOffset + sampleInChunk;
+}
+
+void AudioVisualizerProcessor::writeMidiOutput(juce::MidiBuffer& midiMessages, int numSamples)
+{
+    constexpr int channel = 1;
+    const int notes[numOnsetNotes] = { kickMidiNote, onsetMidiNote };
+
+    if (!midiOutputEnabled.load())
+    {
+        // Switched off: release anything still sounding and forget the rest
+        for (int n = 0; n < numOnsetNotes; ++n)
+        {
+            if (noteOffCountdown[(size_t)n] >= 0)
+                midiMessages.addEvent(juce::MidiMessage::noteOff(channel, notes[n]), 0);
+            noteOffCountdown[(size_t)n] = -1;
+            pendingNoteOnAt[(size_t)n]  = -1;
+        }
+        bandCcSent.fill(-1);
         return;
+    }
+
+    const double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+
+    // Onset notes at the sample the detector fired on, with a short fixed length
+    for (int n = 0; n < numOnsetNotes; ++n)
+    {
+        int& on  = pendingNoteOnAt[(size_t)n];
+        int& off = noteOffCountdown[(size_t)n];
+
+        if (on >= 0)
+        {
+            if (off >= 0)   // still sounding: end it before (or at) the retrigger
+                midiMessages.addEvent(juce::MidiMessage::noteOff(channel, notes[n]), juce::jmin(off, on));
 
+            midiMessages.addEvent(juce::MidiMessage::noteOn(channel, notes[n], (juce::uint8)110), on);
+            off = on + (int)(onsetNoteSeconds * sampleRate);
+            on  = -1;
+        }
+
+        if (off >= 0 && off < numSamples)
+        {
+            midiMessages.addEvent(juce::MidiMessage::noteOff(channel, notes[n]), off);
+            off = -1;
+        }
+        else if (off >= 0)
+        {
+            off -= numSamples;
+        }
+    }
+
+    // Band envelopes as 14-bit CCs, at most bandCcRateHz and only when they move
+    samplesSinceBandCc += numSamples;
+    if (samplesSinceBandCc < (int)(sampleRate / bandCcRateHz))
+        return;
+    samplesSinceBandCc = 0;
+
+    const std::atomic<float>* bands[numBands] = {
+        &subBassEnergy, &bassEnergy, &lowMidEnergy, &midEnergy, &highMidEnergy,
+        &highEnergy, &veryHighEnergy, &kickTransient, &fullSpectrum
+    };
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        int value = juce::roundToInt(juce::jlimit(0.0f, 1.0f, bands[b]->load()) * 16383.0f);
+        int& sent = bandCcSent[(size_t)b];
+        if (sent >= 0 && std::abs(value - sent) < bandCcThreshold)
+            continue;
+
+        midiMessages.addEvent(juce::MidiMessage::controllerEvent(channel, bandCcBase + b, value >> 7), 0);
+        midiMessages.addEvent(juce::MidiMessage::controllerEvent(channel, bandCcBase + 32 + b, value & 127), 0);
+        sent = value;
+    }
+}
+
+void AudioVisualizerProcessor::BandKernel::measure(const float* magnitudes, float binWidth, float* raw)
+{
+    // Initial scaling for frequency response (FrequencyRange order)
+    static constexpr float bandGain[numBands] = {
+        0.4f,   // Sub-bass is very strong
+        0.5f,   // Bass is already strong
+        1.5f,   // Slight boost
+        2.0f,   // Boost mids
+        3.0f,   // More boost for high-mids
+        5.0f,   // Boost highs significantly
+        8.0f,   // Very highs need most boost
+        0.5f,   // Kick in same range as bass (50-90 Hz = tight kick fundamentals)
+        1.0f    // Full spectrum already balanced
+    };
+
+    // Mean magnitude over each band's bins
+    for (int b = 0; b < numBands; ++b)
+    {
+        int start = static_cast<int>(bandEdges[b][0] / binWidth);
+        int end   = static_cast<int>(bandEdges[b][1] / binWidth);
+
+        float sum = 0.0f;
+        for (int bin = start; bin < end && bin < numBins; ++bin)
+            sum += magnitudes[bin];
+
+        raw[b] = sum / (float)std::max(1, end - start) * bandGain[b];
+    }
+}
+
+bool AudioVisualizerProcessor::BandKernel::apply(const float* raw, float* normalised)
+{
+    for (int b = 0; b < numBands; ++b)
+    {
+        // Adaptive normalization - track running averages
+        if (b != kickBand)
+            average[(size_t)b] = average[(size_t)b] * averageSmoothingFactor + raw[b] * (1.0f - averageSmoothingFactor);
+
+        // Normalize current values by running average (kick uses the bass average as its baseline)
+        float norm = std::max(average[(size_t)(b == kickBand ? bassBand : b)], minAverageThreshold);
+        normalised[b] = (raw[b] / norm) * 0.5f;
+    }
+
+    // Kick transient detection - VERY selective criteria
+    float kickNormalized = normalised[kickBand];
+    float kickChange = kickNormalized - previousKick;
+
+    // Simplified kick detection: focus on transient + reasonable energy
+    bool sharpTransient = kickChange > 0.2f;      // Sharp increase indicates transient
+    bool hasEnergy = kickNormalized > 0.3f;       // Has some energy (not total silence)
+    bool fired = sharpTransient && hasEnergy && kickCooldown <= 0;
+
+    // Trigger on transient with energy
+    if (fired)
+    {
+        kickDecay = 1.0f;  // Trigger flash
+        kickCooldown = 3;  // Short cooldown to allow fast kick patterns
+    }
+
+    // Decay kick flash quickly (mimics transient duration)
+    kickDecay *= 0.75f;
+
+    // Countdown cooldown
+    if (kickCooldown > 0)
+        kickCooldown--;
+
+    normalised[kickBand] = kickDecay;
+    previousKick = kickNormalized;  // Store normalized value for next comparison
+    return fired;
+}
+
+void AudioVisualizerProcessor::publishMainBands(const float* normalised)
+{
+    std::atomic<float>* bands[numBands] = {
+        &subBassEnergy, &bassEnergy, &lowMidEnergy, &midEnergy, &highMidEnergy,
+        &highEnergy, &veryHighEnergy, &kickTransient, &fullSpectrum
+    };
+
+    // Store results with clamping
+    for (int b = 0; b < numBands; ++b)
+        bands[b]->store(juce::jlimit(0.0f, 1.0f, normalised[b]));
+}
+
+void AudioVisualizerProcessor::analyseBlock (juce::AudioBuffer<float>& buffer, bool usingLoadedAudio)
+{
     // Always perform FFT analysis on main input bus only (not sidechains)
     auto mainInputBus = getBusBuffer(buffer, true, 0);
     if (mainInputBus.getNumSamples() > 0)
     {
-        // Perform FFT analysis on main input only
-        for (int channel = 0; channel < mainInputBus.getNumChannels(); ++channel)
-        {
-            const float* channelData = mainInputBus.getReadPointer(channel);
+        busAnalysis[Main].pushSamples(mainInputBus, fft, windowTable.data(), getSampleRate());
 
-            for (int i = 0; i < mainInputBus.getNumSamples(); ++i)
+        // Pre-analysed file: band energies and spectrum come from the feature cache
+        if (!(usingLoadedAudio && readFeatureCache(mainInputBus.getNumSamples())))
+        {
+            // Perform FFT analysis on main input only
+            for (int channel = 0; channel < mainInputBus.getNumChannels(); ++channel)
             {
-                // Add to FFT buffer
-                fftData[fftDataPos] = channelData[i];
-                fftDataPos++;
+                const float* channelData = mainInputBus.getReadPointer(channel);
 
-                // When we have enough samples, perform FFT
-                if (fftDataPos >= fftSize)
+                for (int i = 0; i < mainInputBus.getNumSamples(); ++i)
                 {
-                    fftDataPos = 0;
-
-                    // Apply windowing function
-                    window.multiplyWithWindowingTable(fftData.data(), fftSize);
-
-                    // Perform FFT
-                    fft.performFrequencyOnlyForwardTransform(fftData.data());
-
-                    // Analyze frequency bands
-                    float sampleRate = getSampleRate();
-                    float binWidth = sampleRate / fftSize;
-
-                    // Calculate frequency ranges for all bands
-                    int subBassStart = static_cast<int>(20.0f / binWidth);
-                    int subBassEnd = static_cast<int>(60.0f / binWidth);
-                    int bassStart = subBassEnd;
-                    int bassEnd = static_cast<int>(250.0f / binWidth);
-                    int kickStart = static_cast<int>(50.0f / binWidth);   // Kick-specific range (narrower)
-                    int kickEnd = static_cast<int>(90.0f / binWidth);     // 50-90 Hz = tight kick fundamentals
-                    int lowMidStart = bassEnd;
-                    int lowMidEnd = static_cast<int>(500.0f / binWidth);
-                    int midStart = lowMidEnd;
-                    int midEnd = static_cast<int>(2000.0f / binWidth);
-                    int highMidStart = midEnd;
-                    int highMidEnd = static_cast<int>(4000.0f / binWidth);
-                    int highStart = highMidEnd;
-                    int highEnd = static_cast<int>(8000.0f / binWidth);
-                    int veryHighStart = highEnd;
-                    int veryHighEnd = static_cast<int>(20000.0f / binWidth);
-
-                    // Sum energy in each band
-                    float subBass = 0.0f, bass = 0.0f, kick = 0.0f;
-                    float lowMid = 0.0f, mid = 0.0f, highMid = 0.0f;
-                    float high = 0.0f, veryHigh = 0.0f, full = 0.0f;
-
-                    for (int bin = subBassStart; bin < subBassEnd && bin < fftSize / 2; ++bin)
-                        subBass += fftData[bin];
-                    for (int bin = bassStart; bin < bassEnd && bin < fftSize / 2; ++bin)
-                        bass += fftData[bin];
-                    for (int bin = kickStart; bin < kickEnd && bin < fftSize / 2; ++bin)
-                        kick += fftData[bin];  // Separate kick detection band
-                    for (int bin = lowMidStart; bin < lowMidEnd && bin < fftSize / 2; ++bin)
-                        lowMid += fftData[bin];
-                    for (int bin = midStart; bin < midEnd && bin < fftSize / 2; ++bin)
-                        mid += fftData[bin];
-                    for (int bin = highMidStart; bin < highMidEnd && bin < fftSize / 2; ++bin)
-                        highMid += fftData[bin];
-                    for (int bin = highStart; bin < highEnd && bin < fftSize / 2; ++bin)
-                        high += fftData[bin];
-                    for (int bin = veryHighStart; bin < veryHighEnd && bin < fftSize / 2; ++bin)
-                        veryHigh += fftData[bin];
-                    for (int bin = subBassStart; bin < veryHighEnd && bin < fftSize / 2; ++bin)
-                        full += fftData[bin];
-
-                    // Normalize by number of bins
-                    subBass /= std::max(1, subBassEnd - subBassStart);
-                    bass /= std::max(1, bassEnd - bassStart);
-                    kick /= std::max(1, kickEnd - kickStart);
-                    lowMid /= std::max(1, lowMidEnd - lowMidStart);
-                    mid /= std::max(1, midEnd - midStart);
-                    highMid /= std::max(1, highMidEnd - highMidStart);
-                    high /= std::max(1, highEnd - highStart);
-                    veryHigh /= std::max(1, veryHighEnd - veryHighStart);
-                    full /= std::max(1, veryHighEnd - subBassStart);
-
-                    // Initial scaling for frequency response
-                    subBass *= 0.4f;   // Sub-bass is very strong
-                    bass *= 0.5f;      // Bass is already strong
-                    kick *= 0.5f;      // Kick in same range as bass
-                    lowMid *= 1.5f;    // Slight boost
-                    mid *= 2.0f;       // Boost mids
-                    highMid *= 3.0f;   // More boost for high-mids
-                    high *= 5.0f;      // Boost highs significantly
-                    veryHigh *= 8.0f;  // Very highs need most boost
-                    full *= 1.0f;      // Full spectrum already balanced
-
-                    // Adaptive normalization - track running averages
-                    subBassAverage = subBassAverage * averageSmoothingFactor + subBass * (1.0f - averageSmoothingFactor);
-                    bassAverage = bassAverage * averageSmoothingFactor + bass * (1.0f - averageSmoothingFactor);
-                    lowMidAverage = lowMidAverage * averageSmoothingFactor + lowMid * (1.0f - averageSmoothingFactor);
-                    midAverage = midAverage * averageSmoothingFactor + mid * (1.0f - averageSmoothingFactor);
-                    highMidAverage = highMidAverage * averageSmoothingFactor + highMid * (1.0f - averageSmoothingFactor);
-                    highAverage = highAverage * averageSmoothingFactor + high * (1.0f - averageSmoothingFactor);
-                    veryHighAverage = veryHighAverage * averageSmoothingFactor + veryHigh * (1.0f - averageSmoothingFactor);
-                    fullSpectrumAverage = fullSpectrumAverage * averageSmoothingFactor + full * (1.0f - averageSmoothingFactor);
-
-                    // Track kick average separately for normalized kick detection
-                    float kickAverage = bassAverage;  // Use bass average as baseline for kick
-
-                    // Ensure minimum threshold to avoid division by zero
-                    float subBassNorm = std::max(subBassAverage, minAverageThreshold);
-                    float bassNorm = std::max(bassAverage, minAverageThreshold);
-                    float lowMidNorm = std::max(lowMidAverage, minAverageThreshold);
-                    float midNorm = std::max(midAverage, minAverageThreshold);
-                    float highMidNorm = std::max(highMidAverage, minAverageThreshold);
-                    float highNorm = std::max(highAverage, minAverageThreshold);
-                    float veryHighNorm = std::max(veryHighAverage, minAverageThreshold);
-                    float kickNorm = std::max(kickAverage, minAverageThreshold);
-                    float fullNorm = std::max(fullSpectrumAverage, minAverageThreshold);
-
-                    // Normalize current values by running average
-                    float subBassNormalized = (subBass / subBassNorm) * 0.5f;
-                    float bassNormalized = (bass / bassNorm) * 0.5f;
-                    float kickNormalized = (kick / kickNorm) * 0.5f;
-                    float lowMidNormalized = (lowMid / lowMidNorm) * 0.5f;
-                    float midNormalized = (mid / midNorm) * 0.5f;
-                    float highMidNormalized = (highMid / highMidNorm) * 0.5f;
-                    float highNormalized = (high / highNorm) * 0.5f;
-                    float veryHighNormalized = (veryHigh / veryHighNorm) * 0.5f;
-                    float fullNormalized = (full / fullNorm) * 0.5f;
-
-                    // Store results with clamping
-                    subBassEnergy.store(juce::jlimit(0.0f, 1.0f, subBassNormalized));
-                    bassEnergy.store(juce::jlimit(0.0f, 1.0f, bassNormalized));
-                    lowMidEnergy.store(juce::jlimit(0.0f, 1.0f, lowMidNormalized));
-                    midEnergy.store(juce::jlimit(0.0f, 1.0f, midNormalized));
-                    highMidEnergy.store(juce::jlimit(0.0f, 1.0f, highMidNormalized));
-                    highEnergy.store(juce::jlimit(0.0f, 1.0f, highNormalized));
-                    veryHighEnergy.store(juce::jlimit(0.0f, 1.0f, veryHighNormalized));
-                    fullSpectrum.store(juce::jlimit(0.0f, 1.0f, fullNormalized));
-
-                    // Kick transient detection - VERY selective criteria
-                    float kickChange = kickNormalized - previousBassForKick;
-
-                    // Simplified kick detection: focus on transient + reasonable energy
-                    bool sharpTransient = kickChange > 0.2f;      // Sharp increase indicates transient
-                    bool hasEnergy = kickNormalized > 0.3f;       // Has some energy (not total silence)
-                    bool cooldownReady = kickCooldown <= 0;
-
-                    // Trigger on transient with energy
-                    if (sharpTransient && hasEnergy && cooldownReady)
+                    // Add to FFT buffer
+                    fftData[fftDataPos] = channelData[i];
+                    fftDataPos++;
+
+                    // When we have enough samples, perform FFT
+                    if (fftDataPos >= fftSize)
                     {
-                        kickDecay = 1.0f;  // Trigger flash
-                        kickCooldown = 3; // Short cooldown to allow fast kick patterns
+                        fftDataPos = 0;
+
+                        // Apply windowing function
+                        window.multiplyWithWindowingTable(fftData.data(), fftSize);
+
+                        // Perform FFT
+                        fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+                        // Analyze frequency bands
+                        float sampleRate = getSampleRate();
+                        float binWidth = sampleRate / fftSize;
+
+                        // Spectral descriptors and chroma from the same magnitudes
+                        chromaMap.prepare(sampleRate);
+                        melMap.prepare(sampleRate);
+                        busAnalysis[Main].processMagnitudes(fftData.data(), binWidth, chromaMap, melMap);
+
+                        // General onsets: spectral flux crossing well above its running level
+                        float flux = busAnalysis[Main].flux.load();
+                        if (flux > onsetFluxThreshold && previousFluxForOnset <= onsetFluxThreshold)
+                            queueOnsetNote(1, i);
+                        previousFluxForOnset = flux;
+
+                        // Band energies, auto-gain and kick detection
+                        float raw[numBands], normalised[numBands];
+                        BandKernel::measure(fftData.data(), binWidth, raw);
+                        if (mainBands.apply(raw, normalised))
+                            queueOnsetNote(0, i);
+                        publishMainBands(normalised);
                     }
-
-                    // Decay kick flash quickly (mimics transient duration)
-                    kickDecay *= 0.75f;  // Faster decay for sharper flash
-
-                    // Countdown cooldown
-                    if (kickCooldown > 0)
-                        kickCooldown--;
-
-                    kickTransient.store(juce::jlimit(0.0f, 1.0f, kickDecay));
-                    previousBassForKick = kickNormalized;  // Store normalized value for next comparison
                 }
             }
         }
     }
 
+    // Narrow spectrum views, before sidechains are mixed into the main channels
+    processResonators(buffer, mainInputBus, usingLoadedAudio);
+
     // Reset sidechain flags
     topHasSidechain.store(false);
     bottomLeftHasSidechain.store(false);
@@ -350,18 +563,9 @@ void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
             }
 
             // Always analyze if bus exists, even if silent
-            analyzeSidechainBus(topBus, topFftData, topFftDataPos,
+            analyzeSidechainBus(topBus, topFftData, topFftDataPos, busAnalysis[Top],
                                topSubBass, topBass, topLowMid, topMid,
                                topHighMid, topHigh, topVeryHigh, topKick, topFull);
-
-            // Mix sidechain audio into main output so it's audible (only if has audio)
-            if (magnitude > 0.0001f)
-            {
-                for (int ch = 0; ch < juce::jmin(topBus.getNumChannels(), 2); ++ch)
-                {
-                    buffer.addFrom(ch, 0, topBus, ch, 0, topBus.getNumSamples());
-                }
-            }
         }
 
         // Analyze Bottom Left sidechain (bus 2)
@@ -375,18 +579,9 @@ void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
             }
 
             // Always analyze if bus exists, even if silent
-            analyzeSidechainBus(bottomLeftBus, bottomLeftFftData, bottomLeftFftDataPos,
+            analyzeSidechainBus(bottomLeftBus, bottomLeftFftData, bottomLeftFftDataPos, busAnalysis[BottomLeft],
                                bottomLeftSubBass, bottomLeftBass, bottomLeftLowMid, bottomLeftMid,
                                bottomLeftHighMid, bottomLeftHigh, bottomLeftVeryHigh, bottomLeftKick, bottomLeftFull);
-
-            // Mix sidechain audio into main output so it's audible (only if has audio)
-            if (magnitude > 0.0001f)
-            {
-                for (int ch = 0; ch < juce::jmin(bottomLeftBus.getNumChannels(), 2); ++ch)
-                {
-                    buffer.addFrom(ch, 0, bottomLeftBus, ch, 0, bottomLeftBus.getNumSamples());
-                }
-            }
         }
 
         // Analyze Bottom Right sidechain (bus 3)
@@ -400,18 +595,9 @@ void AudioVisualizerProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
             }
 
             // Always analyze if bus exists, even if silent
-            analyzeSidechainBus(bottomRightBus, bottomRightFftData, bottomRightFftDataPos,
+            analyzeSidechainBus(bottomRightBus, bottomRightFftData, bottomRightFftDataPos, busAnalysis[BottomRight],
                                bottomRightSubBass, bottomRightBass, bottomRightLowMid, bottomRightMid,
                                bottomRightHighMid, bottomRightHigh, bottomRightVeryHigh, bottomRightKick, bottomRightFull);
-
-            // Mix sidechain audio into main output so it's audible (only if has audio)
-            if (magnitude > 0.0001f)
-            {
-                for (int ch = 0; ch < juce::jmin(bottomRightBus.getNumChannels(), 2); ++ch)
-                {
-                    buffer.addFrom(ch, 0, bottomRightBus, ch, 0, bottomRightBus.getNumSamples());
-                }
-            }
         }
     }
 
@@ -450,48 +636,113 @@ void AudioVisualizerProcessor::setStateInformation (const void* data, int sizeIn
 {
     savedEditorState.setSize (0);
     savedEditorState.append (data, (size_t)sizeInBytes);
+
+    // MIDI output and pre-analysis run without an editor, so pick their switches out of the editor state here
+    if (auto xml = juce::parseXML(juce::String::fromUTF8((const char*)data, sizeInBytes)))
+    {
+        midiOutputEnabled.store(xml->getBoolAttribute("midiOutput", false));
+        preAnalysisEnabled.store(xml->getBoolAttribute("preAnalyse", false));
+    }
+}
+
+juce::AudioFormatReader* AudioVisualizerProcessor::createReaderFor(const juce::File& file)
+{
+    // Uncompressed formats (WAV/AIFF) can be read straight out of the page cache:
+    // seeks and read-ahead become memory reads, and only touched pages are resident
+    if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+    {
+        if (auto* mapped = format->createMemoryMappedReader(file))
+        {
+            if (mapped->mapEntireFile())
+                return mapped;
+
+            delete mapped;
+        }
+    }
+
+    // Compressed formats (and anything that couldn't be mapped) use the streaming reader
+    return formatManager.createReaderFor(file);
 }
 
 void AudioVisualizerProcessor::loadAudioFile(const juce::File& file)
 {
-    auto* reader = formatManager.createReaderFor(file);
+    playlist.clear();
+    startLoad(file, -1);
+}
+
+void AudioVisualizerProcessor::setPlaylist(const juce::Array<juce::File>& files, bool loop,
+                                           NormalisationPolicy policy)
+{
+    if (files.isEmpty()) return;
+
+    playlist      = files;
+    playlistLoops = loop;
+    normalisationPolicy.store((int)policy);
+    startLoad(files.getFirst(), 0);
+}
+
+void AudioVisualizerProcessor::startLoad(const juce::File& file, int playlistIndex)
+{
+    releaseRetiredTracks();
+    startTimerHz(10);
 
-    if (reader != nullptr)
+    // Anything prefetched belonged to the previous file / playlist
+    const int generation = ++loadGeneration;
+    delete queuedTrack.exchange(nullptr, std::memory_order_acq_rel);
+
+    loadProgress.store(0.0f);
+    loadState.store((int)LoadState::Loading);
+
+    // Opening, header parsing and VBR scans happen here, off the message thread
+    loaderPool.addJob([this, file, generation, playlistIndex]
     {
-        auto newSource = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
-        transportSource.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-        readerSource.reset(newSource.release());
-        audioLoaded = true;
-        playing = false; // Reset playing state
-        transportSource.setPosition(0.0);
+        auto isStale = [this, generation] { return loadGeneration.load() != generation; };
 
-        // Reset adaptive normalization for new song
-        bassAverage = 0.0f;
-        midAverage = 0.0f;
-        highAverage = 0.0f;
-    }
+        auto* reader = createReaderFor(file);
+        loadProgress.store(0.3f);
+
+        auto track = std::make_unique<LoadedTrack>();
+        if (reader == nullptr
+         || !track->open(reader, readAheadThread, readAheadSeconds.load(),
+                         preparedBlockSize.load(), preparedSampleRate.load()))
+        {
+            if (!isStale())
+                loadState.store((int)LoadState::Failed);
+            return;
+        }
+
+        track->prime(loadProgress, 0.3f, 1.0f);
+        track->playlistIndex = playlistIndex;
+        if (isStale())
+            return;
+
+        if (preAnalysisEnabled.load())
+            track->features = startPreAnalysis(file, *track);
+
+        // Hand over; a track the audio thread never picked up is ours to free, as is
+        // anything the previous playlist prefetched before this load was requested
+        delete queuedTrack.exchange(nullptr, std::memory_order_acq_rel);
+        delete incomingTrack.exchange(track.release(), std::memory_order_acq_rel);
+
+        playing = false; // Reset playing state
+        audioLoaded = true;
+        loadProgress.store(1.0f);
+        loadState.store((int)LoadState::Ready);
+    });
 }
 
 void AudioVisualizerProcessor::setPlaying(bool shouldPlay)
 {
-    // Just set the flag - don't touch transportSource
-    // The transport keeps running but we control output via the playing flag in processBlock
+    // Just set the flag; processBlock only pulls from the track while playing,
+    // so pausing never blocks and resumes exactly where it stopped
     playing = shouldPlay;
-
-    // Only start the transport if it's not already playing
-    if (playing && !transportSource.isPlaying())
-    {
-        transportSource.start();
-    }
-    // NOTE: We deliberately DON'T call transportSource.stop() because it blocks
-    // Instead, processBlock will simply not read from the transport when paused
-    // The transport continues running silently in the background
 }
 
-void AudioVisualizerProcessor::getSpectrumForRange(float minFreq, float maxFreq, std::vector<float>& output, int numPoints, PanelID panel) const
+void AudioVisualizerProcessor::getSpectrumForRange(SpectrumResampler& resampler, float minFreq, float maxFreq,
+                                                   std::vector<float>& output, int numPoints, PanelID panel) const
 {
     output.clear();
-    output.resize(numPoints, 0.0f);
+    output.resize((size_t)std::max(0, numPoints), 0.0f);
 
     // Select the appropriate FFT data array based on panel and whether it has active sidechain
     const std::array<float, fftSize * 2>* fftDataPtr = &fftData;
@@ -503,45 +754,25 @@ void AudioVisualizerProcessor::getSpectrumForRange(float minFreq, float maxFreq,
         fftDataPtr = &bottomRightFftData;
     // Otherwise use main fftData
 
-    // Get sample rate from transport source
-    double sampleRate = 44100.0; // Default
-    if (readerSource && readerSource->getAudioFormatReader())
-        sampleRate = readerSource->getAudioFormatReader()->sampleRate;
-
-    // Calculate bin range for this frequency range
-    float binWidth = (float)sampleRate / (float)fftSize;
-    int minBin = (int)(minFreq / binWidth);
-    int maxBin = (int)(maxFreq / binWidth);
+    // The analysed audio runs at the device rate (files are resampled to it)
+    double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
 
-    // Clamp to valid range
-    minBin = juce::jlimit(0, fftSize / 2, minBin);
-    maxBin = juce::jlimit(0, fftSize / 2, maxBin);
-
-    if (maxBin <= minBin)
+    if (numPoints < 2 || maxFreq <= minFreq)
         return;
 
-    // Sample the FFT bins and map to output points
-    for (int i = 0; i < numPoints; ++i)
-    {
-        float ratio = (float)i / (float)(numPoints - 1);
-        int bin = minBin + (int)(ratio * (maxBin - minBin));
+    // performFrequencyOnlyForwardTransform leaves magnitudes in bins 0 .. fftSize / 2
+    resampler.prepare(numPoints, minFreq, maxFreq, sampleRate, fftSize);
+    resampler.process(fftDataPtr->data(), output.data());
 
-        if (bin < fftSize / 2)
-        {
-            // Get magnitude from FFT data (complex to magnitude)
-            float real = (*fftDataPtr)[bin * 2];
-            float imag = (*fftDataPtr)[bin * 2 + 1];
-            float magnitude = std::sqrt(real * real + imag * imag);
-
-            // Normalize and scale for display
-            output[i] = juce::jlimit(0.0f, 1.0f, magnitude * 0.1f);
-        }
-    }
+    // Normalize and scale for display
+    for (auto& v : output)
+        v = juce::jlimit(0.0f, 1.0f, v * 0.1f);
 }
 
 void AudioVisualizerProcessor::analyzeSidechainBus(const juce::AudioBuffer<float>& bus,
                                                    std::array<float, fftSize * 2>& fftDataArray,
                                                    int& fftPos,
+                                                   BusAnalysis& analysis,
                                                    std::atomic<float>& subBass, std::atomic<float>& bass,
                                                    std::atomic<float>& lowMid, std::atomic<float>& mid,
                                                    std::atomic<float>& highMid, std::atomic<float>& high,
@@ -550,6 +781,8 @@ void AudioVisualizerProcessor::analyzeSidechainBus(const juce::AudioBuffer<float
 {
     if (bus.getNumSamples() == 0) return;
 
+    analysis.pushSamples(bus, fft, windowTable.data(), getSampleRate());
+
     for (int channel = 0; channel < bus.getNumChannels(); ++channel)
     {
         const float* channelData = bus.getReadPointer(channel);
@@ -567,6 +800,10 @@ void AudioVisualizerProcessor::analyzeSidechainBus(const juce::AudioBuffer<float
                 float sampleRate = getSampleRate();
                 float binWidth = sampleRate / fftSize;
 
+                chromaMap.prepare(sampleRate);
+                melMap.prepare(sampleRate);
+                analysis.processMagnitudes(fftDataArray.data(), binWidth, chromaMap, melMap);
+
                 int subBassStart = static_cast<int>(20.0f / binWidth);
                 int subBassEnd = static_cast<int>(60.0f / binWidth);
                 int bassStart = subBassEnd;
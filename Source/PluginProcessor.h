@@ -3,8 +3,10 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_dsp/juce_dsp.h>
+#include "SpectrumResampler.h"
 
-class AudioVisualizerProcessor : public juce::AudioProcessor
+class AudioVisualizerProcessor : public juce::AudioProcessor,
+                                 private juce::Timer
 {
 public:
     AudioVisualizerProcessor();
@@ -14,6 +16,8 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -37,9 +41,37 @@ public:
     void saveEditorState (const juce::MemoryBlock& state) { savedEditorState = state; }
     const juce::MemoryBlock& getEditorState() const       { return savedEditorState; }
 
-    // Audio file handling
+    // Audio file handling. Loading runs on a background job; the finished track is
+    // swapped in by the audio thread at the next block.
+    enum class LoadState { Idle, Loading, Ready, Failed };
     void loadAudioFile(const juce::File& file);
-    bool isAudioLoaded() const { return audioLoaded; }
+    bool isAudioLoaded() const { return audioLoaded.load(); }
+    LoadState getLoadState() const   { return (LoadState)loadState.load(); }
+    float getLoadProgress() const    { return loadProgress.load(); }   // 0-1 while Loading
+
+    // Playlist (Standalone): plays the files in order, prefetching the next one in the
+    // background and splicing it in at the exact last frame of the current one.
+    // CarryOver keeps the adaptive normalization running across tracks; Reset
+    // starts every track from scratch like a fresh load.
+    enum class NormalisationPolicy { CarryOver, Reset };
+    void setPlaylist(const juce::Array<juce::File>& files, bool loop,
+                     NormalisationPolicy policy = NormalisationPolicy::CarryOver);
+    int  getPlaylistSize() const  { return playlist.size(); }
+    int  getPlaylistIndex() const { return currentPlaylistIndex.load(); }   // -1 = no playlist
+
+    // Standalone playback read-ahead (takes effect from the next loaded file) and the
+    // number of blocks the read-ahead thread failed to fill in time
+    void   setReadAheadSeconds(double seconds) { readAheadSeconds.store(juce::jlimit(0.1, 30.0, seconds)); }
+    double getReadAheadSeconds() const         { return readAheadSeconds.load(); }
+    int    getPlaybackUnderruns() const        { return playbackUnderruns.load(); }
+
+    // Optional pre-analysis (Standalone): each loaded file is analysed in parallel chunks
+    // into a memory-mapped feature file keyed by its content, reused on later loads.
+    // Once it is ready the main bus band energies and spectrum are looked up by
+    // playback position instead of running the band FFT.
+    void  setPreAnalysisEnabled(bool shouldAnalyse) { preAnalysisEnabled.store(shouldAnalyse); }
+    bool  isPreAnalysisEnabled() const              { return preAnalysisEnabled.load(); }
+    float getPreAnalysisProgress() const            { return preAnalysisProgress.load(); }   // -1 = none, 1 = ready
     void setPlaying(bool shouldPlay);
     bool isPlaying() const
     {
@@ -73,6 +105,39 @@ public:
     float getKickTransient(PanelID panel) const;
     float getFullSpectrum(PanelID panel) const;
 
+    // Spectral descriptors (per panel, normalised 0-1, computed in the band FFT pass)
+    float getSpectralCentroid(PanelID panel) const { return analysisFor(panel).centroid.load(); }
+    float getSpectralSpread(PanelID panel) const   { return analysisFor(panel).spread.load(); }
+    float getSpectralFlatness(PanelID panel) const { return analysisFor(panel).flatness.load(); }
+    float getSpectralRolloff(PanelID panel) const  { return analysisFor(panel).rolloff.load(); }
+    float getSpectralFlux(PanelID panel) const     { return analysisFor(panel).flux.load(); }
+
+    // Chroma (12 pitch classes, C = 0), each normalised so the strongest class is 1
+    float getChroma(PanelID panel, int pitchClass) const { return analysisFor(panel).chroma[(size_t)pitchClass].load(); }
+    int   getDominantPitchClass(PanelID panel) const     { return analysisFor(panel).dominantPitchClass.load(); }  // -1 = none
+    float getPitchClassStrength(PanelID panel) const     { return analysisFor(panel).pitchClassStrength.load(); }
+
+    // Monophonic pitch (MPM). Frequency holds the last confident estimate.
+    float getPitchHz(PanelID panel) const          { return analysisFor(panel).pitchHz.load(); }
+    float getPitchConfidence(PanelID panel) const  { return analysisFor(panel).pitchConfidence.load(); }
+
+    // Stereo field per band (band = FrequencyRange index, SubBass .. FullSpectrum)
+    static constexpr int numBands = 9;
+    float getStereoCorrelation(PanelID panel, int band) const { return analysisFor(panel).stereoCorrelation[(size_t)band].load(); }  // -1..1
+    float getStereoWidth(PanelID panel, int band) const       { return analysisFor(panel).stereoWidth[(size_t)band].load(); }        // side/(mid+side), 0..1
+    float getStereoPan(PanelID panel, int band) const         { return analysisFor(panel).stereoPan[(size_t)band].load(); }          // -1 (L) .. 1 (R)
+
+    // Harmonic/percussive separated band energies (band = FrequencyRange index), auto-gained 0-1
+    float getHarmonicEnergy(PanelID panel, int band) const   { return analysisFor(panel).harmonicEnergy[(size_t)band].load(); }
+    float getPercussiveEnergy(PanelID panel, int band) const { return analysisFor(panel).percussiveEnergy[(size_t)band].load(); }
+
+    // Section changes (drops, breakdowns): the counter increments once per detected boundary.
+    // Boundaries are reported about noveltyKernelHalf feature frames (~4 s) after they happen.
+    int   getSectionChangeCount(PanelID panel) const { return analysisFor(panel).sectionChangeCount.load(); }
+    // The counter of one bus as-is, for callers that resolve the sidechain themselves
+    int   getBusSectionChangeCount(PanelID bus) const { return busAnalysis[bus].sectionChangeCount.load(); }
+    float getNovelty(PanelID panel) const            { return analysisFor(panel).novelty.load(); }   // 0-1
+
     // Check if panel has active sidechain routing
     bool hasSidechainInput(PanelID panel) const {
         if (panel == Top) return topHasSidechain.load();
@@ -81,16 +146,116 @@ public:
         return false;
     }
 
-    // Get FFT spectrum data for frequency range
-    void getSpectrumForRange(float minFreq, float maxFreq, std::vector<float>& output, int numPoints, PanelID panel = Main) const;
+    // FFT spectrum for a frequency range, numPoints values 0-1 on a log-frequency
+    // axis. The caller owns the resampler (one per view) so its table is reused.
+    void getSpectrumForRange(SpectrumResampler& resampler, float minFreq, float maxFreq,
+                             std::vector<float>& output, int numPoints, PanelID panel = Main) const;
+
+    // Like getSpectrumForRange, but ranges too narrow for the FFT (fewer bins than
+    // points) are read from a resonator bank tuned to log-spaced points across them.
+    // slot identifies the caller (0 .. maxResonatorBanks-1, one per editor panel);
+    // any thread may call, but only one at a time per slot (see ResonatorBank).
+    static constexpr int maxResonatorBanks = 4;
+    static constexpr int maxResonatorPoints = 128;
+    void getDetailedSpectrumForRange(int slot, SpectrumResampler& resampler, float minFreq, float maxFreq,
+                                     std::vector<float>& output, int numPoints, PanelID panel = Main);
+    void releaseResonatorBank(int slot);
+
+    // MIDI notes / CCs received by processBlock, stamped with the wall-clock time
+    // (Time::getMillisecondCounterHiRes) at which their sample should be heard
+    struct MidiTrigger {
+        double presentationMs = 0.0;
+        int    channel = 1;
+        int    number  = 0;        // note or controller number
+        float  value   = 0.0f;     // velocity or controller value, 0-1
+        bool   isController = false;
+    };
+
+    // Message thread: moves up to maxTriggers queued triggers into dest, returns the count
+    int popMidiTriggers(MidiTrigger* dest, int maxTriggers);
+
+    // MIDI output: kick / onset notes at their detected sample, band energies as 14-bit CCs
+    // (MSB on CC 20-28, LSB on CC 52-60, FrequencyRange order), channel 1
+    void setMidiOutputEnabled(bool shouldSend) { midiOutputEnabled.store(shouldSend); }
+    bool isMidiOutputEnabled() const           { return midiOutputEnabled.load(); }
 
 private:
     juce::AudioFormatManager formatManager;
-    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-    juce::AudioTransportSource transportSource;
+    juce::AudioFormatReader* createReaderFor(const juce::File& file);   // memory-mapped when the format allows
+
+    struct FeatureCache;
+
+    // A fully opened file: reader -> read-ahead buffer. Built and primed on a loader
+    // job, played on the audio thread, destroyed on the message thread.
+    // (implementation in LoadedTrackImpl.cpp)
+    struct LoadedTrack {
+        ~LoadedTrack();
+
+        std::unique_ptr<juce::AudioFormatReaderSource> reader;
+        std::unique_ptr<juce::BufferingAudioSource>    buffering;
+        std::shared_ptr<FeatureCache>                  features;   // null unless pre-analysed
+        double      fileSampleRate  = 0.0;
+        juce::int64 lengthInSamples = 0;
+        int         playlistIndex   = -1;
+
+        bool open(juce::AudioFormatReader* newReader, juce::TimeSliceThread& thread,
+                  double readAheadSeconds, int blockSize, double deviceRate);
+        bool prime(std::atomic<float>& progress, float from, float to);   // waits for the first read-ahead
+    };
+
+    // Feeds the playback resampler from the current track, splicing into the
+    // queued one at its last frame, so track changes are sample-accurate
+    struct TrackReader : juce::AudioSource {
+        explicit TrackReader(AudioVisualizerProcessor& p) : owner(p) {}
+        void prepareToPlay(int, double) override {}
+        void releaseResources() override {}
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override { owner.readTrackSamples(info); }
+        AudioVisualizerProcessor& owner;
+    };
 
-    bool audioLoaded = false;
-    bool playing = false;
+    TrackReader trackReader { *this };
+    juce::ResamplingAudioSource playbackResampler { &trackReader, false, 2 };   // file rate -> device rate
+
+    LoadedTrack* currentTrack = nullptr;                  // audio thread only
+    std::atomic<LoadedTrack*> incomingTrack { nullptr };  // explicit load: replaces the current track
+    std::atomic<LoadedTrack*> queuedTrack { nullptr };    // playlist prefetch: follows the current track
+    static constexpr int maxRetiredTracks = 8;
+    juce::AbstractFifo retiredFifo { maxRetiredTracks };  // audio thread -> message thread
+    std::array<LoadedTrack*, maxRetiredTracks> retiredTracks {};
+    void swapInIncomingTrack();                           // audio thread
+    bool advanceToQueuedTrack();                          // audio thread
+    void makeCurrent(LoadedTrack* track);                 // audio thread
+    void readTrackSamples(const juce::AudioSourceChannelInfo& info);   // audio thread
+    void resetAdaptiveNormalisation();
+    void releaseRetiredTracks();                          // message thread
+
+    // Playlist state (message thread, except where noted)
+    juce::Array<juce::File> playlist;
+    bool playlistLoops = false;
+    std::atomic<int>  normalisationPolicy { (int)NormalisationPolicy::CarryOver };
+    std::atomic<int>  currentPlaylistIndex { -1 };        // written by the audio thread
+    std::atomic<bool> prefetchInFlight { false };
+    void startLoad(const juce::File& file, int playlistIndex);
+    void prefetchNextTrack();
+    void timerCallback() override;                        // frees retired tracks, keeps the prefetch topped up
+
+    juce::ThreadPool loaderPool { 1 };
+    std::atomic<int>   loadGeneration { 0 };              // newer loads make older jobs discard their result
+    std::atomic<int>   loadState { (int)LoadState::Idle };
+    std::atomic<float> loadProgress { 0.0f };
+    std::atomic<int>    preparedBlockSize { 512 };
+    std::atomic<double> preparedSampleRate { 44100.0 };
+
+    juce::TimeSliceThread readAheadThread { "Audio Read-Ahead" };
+    std::atomic<double> readAheadSeconds { 2.0 };
+    std::atomic<int> playbackUnderruns { 0 };
+
+    juce::ThreadPool analysisPool { juce::jmax(1, juce::SystemStats::getNumCpus() - 1) };
+    std::atomic<bool>  preAnalysisEnabled { false };
+    std::atomic<float> preAnalysisProgress { -1.0f };    // of the current track, for the editor
+
+    std::atomic<bool> audioLoaded { false };
+    std::atomic<bool> playing { false };
     std::atomic<bool> dacPlaying { false };  // DAW transport state (VST3/AU)
 
     // FFT Analysis
@@ -98,11 +263,294 @@ private:
     static constexpr int fftSize = 1 << fftOrder;
     juce::dsp::FFT fft { fftOrder };
     juce::dsp::WindowingFunction<float> window { fftSize, juce::dsp::WindowingFunction<float>::hann };
+    std::array<float, fftSize> windowTable;   // same Hann curve, for analyses that window their own frames
+
+    // Band edges (Hz) in FrequencyRange order
+    static constexpr float bandEdges[numBands][2] = {
+        { 20.0f,   60.0f    },   // SubBass
+        { 60.0f,   250.0f   },   // Bass
+        { 250.0f,  500.0f   },   // LowMids
+        { 500.0f,  2000.0f  },   // Mids
+        { 2000.0f, 4000.0f  },   // HighMids
+        { 4000.0f, 8000.0f  },   // Highs
+        { 8000.0f, 20000.0f },   // VeryHighs
+        { 50.0f,   90.0f    },   // KickTransient
+        { 20.0f,   20000.0f }    // FullSpectrum
+    };
+
+    static constexpr int numBins = fftSize / 2;
+    static constexpr int numPitchClasses = 12;
+    static constexpr int pitchWindow = fftSize / 2;   // zero-padded to fftSize -> linear autocorrelation
+    static constexpr int analysisHop = fftSize / 2;   // time-domain analyses run every this many frames
+    static constexpr int hpssTimeWindow = 9;           // hops of history for the harmonic (time) median
+    static constexpr int hpssFreqWindow = 17;          // bins for the percussive (frequency) median
+    static constexpr int numMelBands = 26;
+    static constexpr int numMfcc = 12;                 // c1..c12 (c0 is loudness, which sections shouldn't key on)
+    static constexpr int noveltyFeatureSize = numPitchClasses + numMfcc;
+    static constexpr int noveltyKernelHalf = 8;        // feature frames either side of a candidate boundary
+    static constexpr int noveltyRingSize = noveltyKernelHalf * 2;
+    static constexpr int noveltyHistorySize = 32;      // novelty values for the adaptive threshold
+
+    // Sparse bin -> pitch-class matrix shared by every bus. Each usable bin feeds
+    // the two nearest pitch classes with linear weights; rebuilt only when the
+    // sample rate (or FFT size) changes.
+    struct ChromaMap {
+        struct Entry { int bin; int pitchClass; float weight; };
+
+        std::array<Entry, numBins * 2> entries {};
+        int    numEntries     = 0;
+        double builtForRate   = 0.0;
+        int    builtForSize   = 0;
+
+        void prepare(double sampleRate);   // no-op unless the rate or size changed
+    };
+
+    ChromaMap chromaMap;
+
+    // Sparse bin -> mel-band triangles plus the DCT that turns log mel energies
+    // into MFCCs, shared by every bus and rebuilt only when the sample rate changes
+    struct MelMap {
+        struct Entry { int bin; int band; float weight; };
+
+        std::array<Entry, numBins * 2> entries {};
+        int    numEntries   = 0;
+        double builtForRate = 0.0;
+        float  dct[numMfcc][numMelBands] {};
+
+        void prepare(double sampleRate);
+    };
+
+    MelMap melMap;
+
+    // Band energies of one magnitude frame: raw per-band means (FrequencyRange order)
+    // and the causal auto-gain + kick detector that turns them into the published
+    // 0-1 values. Shared by the live main-bus FFT and the feature cache.
+    struct BandKernel {
+        static constexpr int bassBand = 1, kickBand = 7;   // FrequencyRange::Bass, ::KickTransient
+
+        std::array<float, numBands> average {};   // adaptive normalization (KickTransient keys on Bass)
+        float previousKick = 0.0f;
+        float kickDecay    = 0.0f;
+        int   kickCooldown = 0;   // Prevent retriggering too quickly
+
+        static void measure(const float* magnitudes, float binWidth, float* raw);
+        bool apply(const float* raw, float* normalised);   // true when a kick fired
+        void reset() { average.fill(0.0f); }
+    };
+
+    BandKernel mainBands;
+    void publishMainBands(const float* normalised);
+
+    // Pre-analysed features of one file: per hop the raw band means and a log-quantised
+    // magnitude spectrum. Built by chunk jobs on analysisPool, then written to disk and
+    // read back memory-mapped; a later load of the same content maps the file directly.
+    // (implementation in FeatureCacheImpl.cpp)
+    struct FeatureCache {
+        static constexpr int hopSize    = numBins;   // 50% overlap: the live stereo update rate
+        static constexpr int recordSize = numBands * (int)sizeof(float) + numBins;
+
+        double sampleRate = 0.0;
+        int    numHops    = 0;
+        juce::File cacheFile;
+
+        std::atomic<bool> ready { false };           // records are complete and readable
+        std::atomic<bool> cancelled { false };       // the track went away before we finished
+        std::atomic<bool> failed { false };
+        std::atomic<int>  hopsAnalysed { 0 };
+        std::atomic<int>  chunksRemaining { 0 };
+
+        const float* rawBands(int hop) const { return reinterpret_cast<const float*>(records + (size_t)hop * recordSize); }
+        void readSpectrum(int hop, float* magnitudes, double deviceRate) const;   // fftSize values, FFT output layout
+        int  hopAt(juce::int64 filePosition) const;   // the hop centred nearest the position
+        float getProgress() const { return ready.load() ? 1.0f : (float)hopsAnalysed.load() / (float)juce::jmax(1, numHops); }
+
+        bool prepare(const juce::File& audioFile, double rate, juce::int64 length);   // true if already on disk
+        void analyseChunk(juce::AudioFormatReader& reader, int firstHop, int hopCount);
+        void finish();
+        bool openMapped();
+
+        juce::HeapBlock<char> building;                  // records while the chunk jobs fill them
+        std::unique_ptr<juce::MemoryMappedFile> mapped;
+        const char* records = nullptr;                   // into building or mapped
+    };
+
+    std::shared_ptr<FeatureCache> startPreAnalysis(const juce::File& file, const LoadedTrack& track);   // loader thread
+    bool readFeatureCache(int numSamples);   // audio thread: false when the live FFT must run
+
+    static constexpr int cacheWarmupHops = 64;    // auto-gain history replayed after a jump
+    const FeatureCache* lastCachedFeatures = nullptr;
+    int lastCachedHop = -1;
+
+    // Bank of complex one-pole resonators (a damped sliding DFT), one per point of
+    // a narrow spectrum view. The editor requests a range through the atomics and
+    // bumps requestedGeneration; the audio thread retunes at the next block.
+    // request() writes several atomics one after another, so each bank must have
+    // one requester at a time: the render job of the panel in that slot (a panel
+    // has at most one queued), or the message thread once that job isn't queued.
+    // (implementation in ResonatorBankImpl.cpp)
+    struct ResonatorBank {
+        // Requested by the editor
+        std::atomic<float>    requestedMin { 0.0f };
+        std::atomic<float>    requestedMax { 0.0f };
+        std::atomic<int>      requestedPoints { 0 };   // 0 = bank unused
+        std::atomic<int>      requestedPanel { Main };
+        std::atomic<uint32_t> requestedGeneration { 0 };
+
+        // Audio-thread state (structure of arrays so the point loop vectorises)
+        uint32_t appliedGeneration = 0;
+        int      numPoints = 0;
+        int      panel     = Main;
+        double   tunedForRate = 0.0;
+        std::array<float, maxResonatorPoints> coeffRe {}, coeffIm {};
+        std::array<float, maxResonatorPoints> stateRe {}, stateIm {};
+        std::array<float, maxResonatorPoints> gain {};
+
+        // Published once per block, valid for publishedGeneration's request
+        std::array<std::atomic<float>, maxResonatorPoints> magnitudes {};
+        std::atomic<uint32_t> publishedGeneration { 0 };
+
+        bool request(PanelID panel, float minFreq, float maxFreq, int numPoints);   // slot's requester; false if unchanged
+        void retune(double sampleRate);                                             // audio thread
+        void process(const juce::AudioBuffer<float>& bus);                          // audio thread
+    };
+
+    std::array<ResonatorBank, maxResonatorBanks> resonatorBanks;
+
+    // Audio thread -> editor MIDI trigger queue (single producer, single consumer)
+    static constexpr int midiTriggerCapacity = 256;
+    juce::AbstractFifo midiTriggerFifo { midiTriggerCapacity };
+    std::array<MidiTrigger, midiTriggerCapacity> midiTriggerQueue;
+
+    // MIDI output state (audio thread)
+    static constexpr int    kickMidiNote       = 36;     // GM kick
+    static constexpr int    onsetMidiNote      = 38;     // GM snare: any other onset
+    static constexpr int    numOnsetNotes      = 2;
+    static constexpr double onsetNoteSeconds   = 0.05;
+    static constexpr float  onsetFluxThreshold = 0.8f;   // normalised flux (0.5 = running average)
+    static constexpr int    bandCcBase         = 20;     // LSBs at +32, per the MIDI spec
+    static constexpr double bandCcRateHz       = 100.0;
+    static constexpr int    bandCcThreshold    = 64;     // of 16383, ~0.4%
+    std::atomic<bool> midiOutputEnabled { false };
+    int analysisBlockOffset = 0;                         // start of the chunk being analysed
+    std::array<int, numOnsetNotes> pendingNoteOnAt  { -1, -1 };
+    std::array<int, numOnsetNotes> noteOffCountdown { -1, -1 };
+    std::array<int, numBands> bandCcSent {};
+    int   samplesSinceBandCc   = 0;
+    float previousFluxForOnset = 0.0f;
+
+    // Feeds every active resonator bank from its panel's bus (or main when unrouted)
+    void processResonators(juce::AudioBuffer<float>& buffer,
+                           const juce::AudioBuffer<float>& mainInputBus, bool usingLoadedAudio);
+
+    // Per-bus analysis that runs on the band magnitudes of every FFT hop
+    // (implementation in BusAnalysisImpl.cpp)
+    struct BusAnalysis {
+        // Audio-thread working state
+        std::array<float, numBins> prevMagnitudes {};
+        float fluxAverage = 0.0f;
+        std::array<float, numPitchClasses> chromaSmooth {};
+
+        // L/R history (rings) and scratch for the time-domain analyses
+        std::array<float, fftSize> leftHistory {};
+        std::array<float, fftSize> rightHistory {};
+        int historyPos      = 0;
+        int samplesSinceHop = 0;
+        std::array<float, fftSize * 2> pitchScratch {};
+        std::array<float, pitchWindow> pitchFrame {};
+        std::array<juce::dsp::Complex<float>, fftSize> stereoIn {};
+        std::array<juce::dsp::Complex<float>, fftSize> stereoOut {};
+        std::array<float, numBands> stereoSmooth[3] {};   // correlation, width, pan
+
+        // Harmonic/percussive separation: per-bin ring of recent magnitudes plus
+        // the same values kept sorted, so each hop is one replace per bin
+        std::array<float, numBins * hpssTimeWindow> hpssHistory {};
+        std::array<float, numBins * hpssTimeWindow> hpssSorted {};
+        int hpssPos = 0;
+        std::array<float, numBins> percussiveMedian {};
+        std::array<float, numBands> harmonicAverage {};
+        std::array<float, numBands> percussiveAverage {};
+
+        // Section changes: chroma + MFCC averaged into ~0.5 s feature frames, the
+        // last noveltyRingSize frames with their pairwise similarities (updated one
+        // row per frame), and a checkerboard-kernel novelty curve
+        std::array<float, noveltyFeatureSize> featureSum {};
+        int featureFrames    = 0;   // FFT frames summed into featureSum
+        int hopsSinceFeature = 0;
+        std::array<std::array<float, noveltyFeatureSize>, noveltyRingSize> featureRing {};
+        std::array<std::array<float, noveltyRingSize>, noveltyRingSize> similarity {};   // by ring slot
+        int featureRingPos   = 0;
+        int featureRingCount = 0;
+        std::array<float, noveltyHistorySize> noveltyHistory {};
+        int noveltyHistoryPos   = 0;
+        int noveltyHistoryCount = 0;
+        int framesSinceSection  = 0;
+
+        // Spectral descriptors, normalised 0-1
+        std::atomic<float> centroid { 0.0f };   // log-frequency position of the centre of mass
+        std::atomic<float> spread   { 0.0f };   // log-frequency width around the centroid
+        std::atomic<float> flatness { 0.0f };   // geometric / arithmetic mean (tonal 0 .. noise 1)
+        std::atomic<float> rolloff  { 0.0f };   // log-frequency below which 85% of the energy sits
+        std::atomic<float> flux     { 0.0f };   // positive frame-to-frame change, auto-gained
+
+        // Chroma
+        std::array<std::atomic<float>, numPitchClasses> chroma {};
+        std::atomic<int>   dominantPitchClass { -1 };
+        std::atomic<float> pitchClassStrength { 0.0f };   // how much the winner stands out, 0-1
+
+        // Pitch
+        std::atomic<float> pitchHz         { 0.0f };
+        std::atomic<float> pitchConfidence { 0.0f };   // NSDF clarity of the chosen peak, 0-1
+
+        // Stereo field, per band
+        std::array<std::atomic<float>, numBands> stereoCorrelation {};
+        std::array<std::atomic<float>, numBands> stereoWidth {};
+        std::array<std::atomic<float>, numBands> stereoPan {};
+
+        // Harmonic / percussive band energies
+        std::array<std::atomic<float>, numBands> harmonicEnergy {};
+        std::array<std::atomic<float>, numBands> percussiveEnergy {};
+
+        // Section changes
+        std::atomic<float> novelty { 0.0f };
+        std::atomic<int>   sectionChangeCount { 0 };
+
+        void processMagnitudes(const float* magnitudes, float binWidth,
+                               const ChromaMap& chromaMap, const MelMap& melMap);
+        void processChroma(const float* magnitudes, const ChromaMap& chromaMap);
+        void processHarmonicPercussive(const float* magnitudes, float binWidth);
+        void accumulateFeatures(const float* magnitudes, const MelMap& melMap);
+        void processFeatureFrame();
+
+        // Feeds the time-domain history; runs the hop analyses when due
+        void pushSamples(const juce::AudioBuffer<float>& bus, const juce::dsp::FFT& fft,
+                         const float* windowTable, double sampleRate);
+        void processPitch(const juce::dsp::FFT& fft, double sampleRate);
+        void processStereo(const juce::dsp::FFT& fft, const float* windowTable, double sampleRate);
+    };
+
+    std::array<BusAnalysis, 4> busAnalysis;   // indexed by PanelID
+
+    // Sidechain panels without an active sidechain mirror the main analysis
+    const BusAnalysis& analysisFor(PanelID panel) const
+    {
+        return busAnalysis[hasSidechainInput(panel) ? panel : Main];
+    }
+
+    // Shared by both processBlock precisions; analysis always runs in float
+    void updateHostTransportState();
+    void queueMidiTriggers(const juce::MidiBuffer& midiMessages, int numSamples);
+    void queueOnsetNote(int noteIndex, int sampleInChunk);
+    void writeMidiOutput(juce::MidiBuffer& midiMessages, int numSamples);
+    void analyseBlock(juce::AudioBuffer<float>& buffer, bool usingLoadedAudio);
+    template <typename SampleType>
+    void mixSidechainsIntoMain(juce::AudioBuffer<SampleType>& buffer);
+    juce::AudioBuffer<float> analysisConversionBuffer;   // sized in prepareToPlay
 
     // Helper to analyze a bus and store results in specific panel variables
     void analyzeSidechainBus(const juce::AudioBuffer<float>& bus,
                             std::array<float, fftSize * 2>& fftDataArray,
                             int& fftPos,
+                            BusAnalysis& analysis,
                             std::atomic<float>& subBass, std::atomic<float>& bass,
                             std::atomic<float>& lowMid, std::atomic<float>& mid,
                             std::atomic<float>& highMid, std::atomic<float>& high,
@@ -123,21 +571,6 @@ private:
     std::atomic<float> kickTransient { 0.0f };    // Kick drum transient detector
     std::atomic<float> fullSpectrum { 0.0f };     // All frequencies combined
 
-    // Adaptive normalization - running averages for auto-gain
-    float subBassAverage = 0.0f;
-    float bassAverage = 0.0f;
-    float lowMidAverage = 0.0f;
-    float midAverage = 0.0f;
-    float highMidAverage = 0.0f;
-    float highAverage = 0.0f;
-    float veryHighAverage = 0.0f;
-    float fullSpectrumAverage = 0.0f;
-
-    // Kick detection
-    float previousBassForKick = 0.0f;
-    float kickDecay = 0.0f;
-    int kickCooldown = 0;  // Prevent retriggering too quickly
-
     // Smoothing factors for adaptive gain
     static constexpr float averageSmoothingFactor = 0.95f;  // How fast to adapt (was 0.99)
     static constexpr float minAverageThreshold = 0.001f;    // Prevent division by zero
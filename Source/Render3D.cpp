@@ -0,0 +1,232 @@
+#include "Render3D.h"
+#include "SoftwareRaster.h"
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// Matrices
+// ---------------------------------------------------------------------------
+
+Render3D::Matrix3 Render3D::Matrix3::rotationX(float a)
+{
+    const float c = std::cos(a), s = std::sin(a);
+    return { { 1, 0, 0,   0, c, -s,   0, s, c } };
+}
+
+Render3D::Matrix3 Render3D::Matrix3::rotationY(float a)
+{
+    const float c = std::cos(a), s = std::sin(a);
+    return { { c, 0, s,   0, 1, 0,   -s, 0, c } };
+}
+
+Render3D::Matrix3 Render3D::Matrix3::rotationZ(float a)
+{
+    const float c = std::cos(a), s = std::sin(a);
+    return { { c, -s, 0,   s, c, 0,   0, 0, 1 } };
+}
+
+Render3D::Matrix3 Render3D::Matrix3::operator* (const Matrix3& rhs) const
+{
+    Matrix3 r;
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 3; ++col)
+            r.m[row * 3 + col] = m[row * 3 + 0] * rhs.m[0 * 3 + col]
+                               + m[row * 3 + 1] * rhs.m[1 * 3 + col]
+                               + m[row * 3 + 2] * rhs.m[2 * 3 + col];
+    return r;
+}
+
+Render3D::Vec3 Render3D::Matrix3::operator* (Vec3 v) const
+{
+    return { m[0] * v.x + m[1] * v.y + m[2] * v.z,
+             m[3] * v.x + m[4] * v.y + m[5] * v.z,
+             m[6] * v.x + m[7] * v.y + m[8] * v.z };
+}
+
+// ---------------------------------------------------------------------------
+// Meshes
+// ---------------------------------------------------------------------------
+
+const Render3D::Mesh& Render3D::Mesh::unitBox()
+{
+    static const Mesh box = []
+    {
+        Mesh b;
+        b.x = { -1,  1,  1, -1, -1,  1,  1, -1 };   // front (z = -1), then back (z = 1)
+        b.y = { -1, -1,  1,  1, -1, -1,  1,  1 };
+        b.z = { -1, -1, -1, -1,  1,  1,  1,  1 };
+
+        // Winding = outward normal viewable
+        b.faces   = { { 0, 1, 2, 3 }, { 5, 4, 7, 6 }, { 4, 0, 3, 7 },
+                      { 1, 5, 6, 2 }, { 3, 2, 6, 7 }, { 4, 5, 1, 0 } };
+        b.normals = { { 0, 0, -1 }, { 0, 0, 1 }, { -1, 0, 0 },
+                      { 1, 0, 0 },  { 0, 1, 0 }, { 0, -1, 0 } };
+        return b;
+    }();
+
+    return box;
+}
+
+// ---------------------------------------------------------------------------
+// Frame
+// ---------------------------------------------------------------------------
+
+void Render3D::beginFrame(const Matrix3& r, const Camera& c, Vec3 lightDirection, size_t expectedFaces)
+{
+    rotation = r;
+    camera   = c;
+
+    const float len = std::sqrt(lightDirection.x * lightDirection.x
+                              + lightDirection.y * lightDirection.y
+                              + lightDirection.z * lightDirection.z);
+    towardLight = { -lightDirection.x / len, -lightDirection.y / len, -lightDirection.z / len };
+
+    viewX.clear(); viewY.clear(); viewZ.clear();
+    screenX.clear(); screenY.clear();
+    faces.clear();
+
+    // Room for every face up front: how many survive culling changes as the mesh
+    // turns, and the buffers shouldn't grow mid-animation
+    faces.reserve(expectedFaces);
+}
+
+void Render3D::addInstance(const Mesh& mesh, Vec3 offset, Vec3 scale, juce::Colour colour)
+{
+    const size_t base = viewZ.size();
+    const size_t n    = mesh.z.size();
+    viewX.resize(base + n); viewY.resize(base + n); viewZ.resize(base + n);
+    screenX.resize(base + n); screenY.resize(base + n);
+
+    // Fold the instance's scale and offset into the frame rotation:
+    // view = R * (S * v + offset) = (R * S) * v + R * offset
+    const auto* m = rotation.m;
+    const Vec3 t  = rotation * offset;
+    const float m0 = m[0] * scale.x, m1 = m[1] * scale.y, m2 = m[2] * scale.z;
+    const float m3 = m[3] * scale.x, m4 = m[4] * scale.y, m5 = m[5] * scale.z;
+    const float m6 = m[6] * scale.x, m7 = m[7] * scale.y, m8 = m[8] * scale.z;
+
+    // Straight-line loops over the SoA buffers so the compiler vectorises them
+    const float* ox = mesh.x.data();
+    const float* oy = mesh.y.data();
+    const float* oz = mesh.z.data();
+    float* vx = viewX.data() + base;
+    float* vy = viewY.data() + base;
+    float* vz = viewZ.data() + base;
+    for (size_t i = 0; i < n; ++i)
+    {
+        vx[i] = m0 * ox[i] + m1 * oy[i] + m2 * oz[i] + t.x;
+        vy[i] = m3 * ox[i] + m4 * oy[i] + m5 * oz[i] + t.y;
+        vz[i] = m6 * ox[i] + m7 * oy[i] + m8 * oz[i] + t.z;
+    }
+
+    float* sx = screenX.data() + base;
+    float* sy = screenY.data() + base;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const float k = camera.fov / std::max(vz[i] + camera.distance, 0.01f);
+        sx[i] = vx[i] * k + camera.centreX;
+        sy[i] = vy[i] * k + camera.centreY;
+    }
+
+    const float red   = colour.getFloatRed();
+    const float green = colour.getFloatGreen();
+    const float blue  = colour.getFloatBlue();
+    const float alpha = colour.getFloatAlpha();
+
+    for (size_t f = 0; f < mesh.faces.size(); ++f)
+    {
+        const auto& q = mesh.faces[f];
+        const int numCorners = q[3] < 0 ? 3 : 4;
+        const int c0 = (int)base + q[0], c1 = (int)base + q[1], c2 = (int)base + q[2];
+        const int c3 = numCorners == 4 ? (int)base + q[3] : c2;
+
+        // Triangles count their last corner twice, so weight them back to a true mean
+        const float w  = 1.0f / (float)numCorners;
+        const float w3 = numCorners == 4 ? w : 0.0f;
+        const float cx = (viewX[(size_t)c0] + viewX[(size_t)c1] + viewX[(size_t)c2]) * w + viewX[(size_t)c3] * w3;
+        const float cy = (viewY[(size_t)c0] + viewY[(size_t)c1] + viewY[(size_t)c2]) * w + viewY[(size_t)c3] * w3;
+        const float cz = (viewZ[(size_t)c0] + viewZ[(size_t)c1] + viewZ[(size_t)c2]) * w + viewZ[(size_t)c3] * w3;
+
+        // Back-face cull against the ray from the camera, so it holds off-centre too
+        const Vec3 normal = rotation * mesh.normals[f];
+        if (normal.x * cx + normal.y * cy + normal.z * (cz + camera.distance) >= 0.0f)
+            continue;
+
+        // Ambient + diffuse. Scaling RGB is the same as scaling HSB brightness
+        const float diffuse = juce::jlimit(0.0f, 1.0f, normal.x * towardLight.x
+                                                     + normal.y * towardLight.y
+                                                     + normal.z * towardLight.z);
+        const float shade = 0.25f + 0.75f * diffuse;
+
+        faces.push_back({ { c0, c1, c2, c3 }, numCorners, cz,
+                          juce::Colour::fromFloatRGBA(red * shade, green * shade, blue * shade, alpha)
+                              .getPixelARGB() });
+    }
+}
+
+// Two-pass LSD radix sort on 16-bit depth keys: O(n) for the hundreds of faces
+// a bar field produces, where a comparison sort would dominate the frame
+void Render3D::sortBackToFront()
+{
+    const size_t n = faces.size();
+    order.reserve(faces.capacity());
+    orderScratch.reserve(faces.capacity());
+    keys.reserve(faces.capacity());
+    order.resize(n);
+    orderScratch.resize(n);
+    keys.resize(n);
+
+    float nearest = 1.0e30f, furthest = -1.0e30f;
+    for (const auto& f : faces)
+    {
+        nearest  = std::min(nearest,  f.depth);
+        furthest = std::max(furthest, f.depth);
+    }
+
+    // Key 0 = furthest, so ascending key order is back to front
+    const float toKey = furthest > nearest ? 65535.0f / (furthest - nearest) : 0.0f;
+    for (size_t i = 0; i < n; ++i)
+    {
+        keys[i]  = (juce::uint16)((furthest - faces[i].depth) * toKey);
+        order[i] = (juce::uint32)i;
+    }
+
+    for (int shift = 0; shift < 16; shift += 8)
+    {
+        std::array<juce::uint32, 257> start {};
+        for (size_t i = 0; i < n; ++i)
+            ++start[((keys[order[i]] >> shift) & 0xff) + 1];
+        for (size_t b = 1; b < start.size(); ++b)
+            start[b] += start[b - 1];
+        for (size_t i = 0; i < n; ++i)
+            orderScratch[start[(keys[order[i]] >> shift) & 0xff]++] = order[i];
+        std::swap(order, orderScratch);
+    }
+}
+
+void Render3D::render(const juce::Image::BitmapData& pixels, juce::Colour edgeColour, float edgeWidth)
+{
+    if (faces.empty()) return;
+
+    sortBackToFront();
+
+    const SoftwareRaster raster(pixels);
+    const auto edge = edgeColour.getPixelARGB();
+
+    for (auto index : order)
+    {
+        const auto& f = faces[index];
+
+        const int n = f.numCorners;
+
+        juce::Point<float> corners[4];
+        for (int k = 0; k < n; ++k)
+            corners[k] = { screenX[(size_t)f.corners[k]], screenY[(size_t)f.corners[k]] };
+
+        raster.convexPolygon(corners, n, f.fill);
+
+        if (edgeWidth > 0.0f)
+            for (int k = 0; k < n; ++k)
+                raster.line(corners[k].x, corners[k].y, corners[(k + 1) % n].x, corners[(k + 1) % n].y, edgeWidth, edge);
+    }
+}
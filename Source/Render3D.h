@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include <array>
+#include <vector>
+
+// Small software 3D pipeline shared by the 3D effects: one composed rotation per
+// frame, batched vertex transforms over structure-of-arrays buffers, back-face
+// culling, a radix-sorted painter's order and flat-shaded, antialiased polygons
+// rasterised straight into the panel bitmap. Keep one per effect instance so its
+// buffers are reused from frame to frame.
+// (implementation in Render3D.cpp)
+class Render3D
+{
+public:
+    struct Vec3 { float x, y, z; };
+
+    struct Matrix3
+    {
+        float m[9] = { 1, 0, 0,  0, 1, 0,  0, 0, 1 };
+
+        static Matrix3 rotationX(float angle);
+        static Matrix3 rotationY(float angle);
+        static Matrix3 rotationZ(float angle);
+        Matrix3 operator* (const Matrix3& rhs) const;   // rhs applied first
+        Vec3    operator* (Vec3 v) const;
+    };
+
+    // Quads and triangles (corner 3 < 0) with one outward normal per face (object space)
+    struct Mesh
+    {
+        std::vector<float> x, y, z;
+        std::vector<std::array<int, 4>> faces;
+        std::vector<Vec3> normals;
+
+        static const Mesh& unitBox();   // -1..1 on every axis
+    };
+
+    // Perspective camera looking down +Z from -distance; centre and fov in pixels
+    struct Camera { float centreX, centreY, fov, distance; };
+
+    // expectedFaces: every face of every instance to come this frame, culled or not,
+    // so the face list is sized once instead of growing (or re-reserving) per instance
+    void beginFrame(const Matrix3& rotation, const Camera& camera, Vec3 lightDirection, size_t expectedFaces);
+
+    // Queues one instance of mesh, scaled then offset in object space (scales must be
+    // positive). Back faces are dropped here; the rest wait for render()
+    void addInstance(const Mesh& mesh, Vec3 offset, Vec3 scale, juce::Colour colour);
+
+    // Draws the queued faces back to front, each outlined with edgeColour when edgeWidth > 0
+    void render(const juce::Image::BitmapData& pixels, juce::Colour edgeColour, float edgeWidth);
+
+    int getNumQueuedFaces() const { return (int)faces.size(); }
+
+private:
+    Matrix3 rotation;
+    Camera  camera { 0.0f, 0.0f, 1.0f, 4.0f };
+    Vec3    towardLight { 0.0f, 0.0f, -1.0f };
+
+    // Rotated and projected vertices of everything queued this frame
+    std::vector<float> viewX, viewY, viewZ, screenX, screenY;
+
+    struct Face
+    {
+        int   corners[4];      // into the vertex buffers above
+        int   numCorners;      // 3 or 4
+        float depth;           // mean view-space z, larger = further
+        juce::PixelARGB fill;
+    };
+
+    std::vector<Face>         faces;
+    std::vector<juce::uint32> order, orderScratch;
+    std::vector<juce::uint16> keys;
+
+    void sortBackToFront();
+};
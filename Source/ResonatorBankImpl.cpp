@@ -0,0 +1,184 @@
+#include "PluginProcessor.h"
+#include <cmath>
+#include <algorithm>
+
+// Narrowest resonator bandwidth. Finer spacing than this just blurs neighbours
+// together, and the ring-down (~1 / (pi * bandwidth)) would lag the music.
+static constexpr float kMinResonatorBandwidth = 3.0f;   // Hz
+
+// ---------------------------------------------------------------------------
+// Requester: a panel's render job, or the message thread releasing its slot
+// ---------------------------------------------------------------------------
+
+bool AudioVisualizerProcessor::ResonatorBank::request(PanelID newPanel, float minFreq, float maxFreq, int points)
+{
+    points = juce::jlimit(0, maxResonatorPoints, points);
+
+    if (requestedPoints.load() == points && requestedPanel.load() == newPanel
+     && requestedMin.load() == minFreq && requestedMax.load() == maxFreq)
+        return false;
+
+    requestedMin.store(minFreq);
+    requestedMax.store(maxFreq);
+    requestedPoints.store(points);
+    requestedPanel.store(newPanel);
+    requestedGeneration.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Audio thread
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::ResonatorBank::retune(double sampleRate)
+{
+    uint32_t generation = requestedGeneration.load(std::memory_order_acquire);
+    if (generation == appliedGeneration && sampleRate == tunedForRate)
+        return;
+
+    appliedGeneration = generation;
+    tunedForRate      = sampleRate;
+    numPoints         = sampleRate > 0.0 ? requestedPoints.load() : 0;
+    panel             = requestedPanel.load();
+
+    if (numPoints < 2)
+    {
+        numPoints = 0;
+        return;
+    }
+
+    // Log-spaced like the FFT view, so switching between them keeps the axis
+    const double minFreq = std::max(1.0f, requestedMin.load());
+    const double ratio   = std::pow(std::max(minFreq, (double)requestedMax.load()) / minFreq,
+                                    1.0 / (numPoints - 1));
+
+    for (int k = 0; k < numPoints; ++k)
+    {
+        // Each resonator is as wide as the gap to its neighbour, so the bank tiles the range
+        const double freq      = minFreq * std::pow(ratio, (double)k);
+        const double bandwidth = std::max(freq * (ratio - 1.0), (double)kMinResonatorBandwidth);
+        const double radius    = std::exp(-juce::MathConstants<double>::pi * bandwidth / sampleRate);
+
+        double omega = juce::MathConstants<double>::twoPi * freq / sampleRate;
+        coeffRe[(size_t)k] = (float)(radius * std::cos(omega));
+        coeffIm[(size_t)k] = (float)(radius * std::sin(omega));
+        stateRe[(size_t)k] = 0.0f;
+        stateIm[(size_t)k] = 0.0f;
+        gain[(size_t)k]    = (float)(2.0 * (1.0 - radius));   // steady sine of amplitude A reads A
+    }
+}
+
+void AudioVisualizerProcessor::ResonatorBank::process(const juce::AudioBuffer<float>& bus)
+{
+    int numChannels = std::min(bus.getNumChannels(), 2);
+    if (numChannels == 0 || numPoints == 0) return;
+
+    const float* left  = bus.getReadPointer(0);
+    const float* right = bus.getReadPointer(numChannels - 1);
+
+    const float* cr = coeffRe.data();
+    const float* ci = coeffIm.data();
+    float* yr = stateRe.data();
+    float* yi = stateIm.data();
+    const int n = numPoints;
+
+    // y[k] <- c[k] * y[k] + x: one complex multiply-add per point per sample.
+    // The inner loop has no dependencies between points, so it vectorises.
+    for (int i = 0; i < bus.getNumSamples(); ++i)
+    {
+        const float x = 0.5f * (left[i] + right[i]);
+        for (int k = 0; k < n; ++k)
+        {
+            float re = cr[k] * yr[k] - ci[k] * yi[k] + x;
+            float im = cr[k] * yi[k] + ci[k] * yr[k];
+            yr[k] = re;
+            yi[k] = im;
+        }
+    }
+
+    for (int k = 0; k < n; ++k)
+        magnitudes[(size_t)k].store(gain[(size_t)k] * std::sqrt(yr[k] * yr[k] + yi[k] * yi[k]));
+
+    publishedGeneration.store(appliedGeneration, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// Processor glue
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerProcessor::processResonators(juce::AudioBuffer<float>& buffer,
+                                                 const juce::AudioBuffer<float>& mainInputBus,
+                                                 bool usingLoadedAudio)
+{
+    juce::ScopedNoDenormals noDenormals;   // the recursions ring down towards zero
+    const double sampleRate = getSampleRate();
+
+    for (auto& bank : resonatorBanks)
+    {
+        bank.retune(sampleRate);
+        if (bank.numPoints == 0) continue;
+
+        // Same routing rule as the bands: a sidechain carrying signal, else the main input
+        if (!usingLoadedAudio && bank.panel != Main)
+        {
+            auto bus = getBusBuffer(buffer, true, bank.panel);
+            if (bus.getNumChannels() > 0 && bus.getNumSamples() > 0
+             && bus.getMagnitude(0, bus.getNumSamples()) > 0.0001f)
+            {
+                bank.process(bus);
+                continue;
+            }
+        }
+
+        bank.process(mainInputBus);
+    }
+}
+
+void AudioVisualizerProcessor::getDetailedSpectrumForRange(int slot, SpectrumResampler& resampler,
+                                                           float minFreq, float maxFreq,
+                                                           std::vector<float>& output, int numPoints,
+                                                           PanelID panel)
+{
+    double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    float  binWidth   = (float)sampleRate / (float)fftSize;
+
+    // The FFT already resolves wide ranges; only narrow ones need the bank
+    bool tooNarrow = (maxFreq - minFreq) / binWidth < (float)numPoints;
+    if (slot < 0 || slot >= maxResonatorBanks || numPoints < 2 || !tooNarrow)
+    {
+        if (slot >= 0 && slot < maxResonatorBanks)
+            releaseResonatorBank(slot);
+        getSpectrumForRange(resampler, minFreq, maxFreq, output, numPoints, panel);
+        return;
+    }
+
+    // Wide panels ask for more points than the bank has; it's a few bins wide
+    // anyway, so its points are interpolated out to the requested count
+    const int bankPoints = std::min(numPoints, maxResonatorPoints);
+    auto& bank = resonatorBanks[(size_t)slot];
+    bank.request(panel, minFreq, maxFreq, bankPoints);
+
+    // Until the audio thread has retuned (or while transport is stopped) use the FFT view
+    if (bank.publishedGeneration.load(std::memory_order_acquire) != bank.requestedGeneration.load())
+    {
+        getSpectrumForRange(resampler, minFreq, maxFreq, output, numPoints, panel);
+        return;
+    }
+
+    output.resize((size_t)numPoints);
+    const float step = (float)(bankPoints - 1) / (float)(numPoints - 1);
+    for (int k = 0; k < numPoints; ++k)
+    {
+        const float position = (float)k * step;
+        const int   below    = std::min((int)position, bankPoints - 2);
+        const float a = bank.magnitudes[(size_t)below].load();
+        const float b = bank.magnitudes[(size_t)below + 1].load();
+        output[(size_t)k] = juce::jlimit(0.0f, 1.0f, a + (b - a) * (position - (float)below));
+    }
+}
+
+void AudioVisualizerProcessor::releaseResonatorBank(int slot)
+{
+    if (slot >= 0 && slot < maxResonatorBanks)
+        resonatorBanks[(size_t)slot].request(Main, 0.0f, 0.0f, 0);
+}
@@ -0,0 +1,94 @@
+#include "PluginEditor.h"
+#include <cmath>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------
+// Update
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerEditor::SpectrumBarsInstance::update(float value, float dt)
+{
+    // Band energies: the mean of each group of spectrum points
+    float bands[numBands] = {};
+    float currentPeak = 0.0001f;
+    const int perBand = (int)spectrum.size() / numBands;
+
+    if (perBand > 0)
+    {
+        for (int b = 0; b < numBands; ++b)
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < perBand; ++i)
+                sum += spectrum[(size_t)(b * perBand + i)];
+            bands[b] = sum / (float)perBand;
+            currentPeak = std::max(currentPeak, bands[b]);
+        }
+    }
+
+    // Adaptive normalisation, as on the frequency line
+    const float peakKeep = perFrame(currentPeak > peak ? 0.3f : 0.92f, dt);
+    peak = peak * peakKeep + currentPeak * (1.0f - peakKeep);
+
+    // The front row eases toward the current bands...
+    const float keep = perFrame(0.6f, dt);
+    for (int b = 0; b < numBands; ++b)
+        heights[(size_t)b] = heights[(size_t)b] * keep
+                           + juce::jlimit(0.0f, 1.0f, bands[b] / peak) * (1.0f - keep);
+
+    // ...and the rows behind it are its recent history
+    rowTimer += dt;
+    if (rowTimer >= 1.0f / rowsPerSecond)
+    {
+        rowTimer = std::fmod(rowTimer, 1.0f / rowsPerSecond);
+        for (int r = numRows - 1; r > 0; --r)
+            std::copy_n(heights.begin() + (r - 1) * numBands, numBands, heights.begin() + r * numBands);
+    }
+
+    // Slow turn, quicker with the music
+    yaw += (0.12f + value * 0.6f) * dt;
+}
+
+// ---------------------------------------------------------------------------
+// Draw
+// ---------------------------------------------------------------------------
+
+void AudioVisualizerEditor::SpectrumBarsInstance::draw(
+    const juce::Image::BitmapData& pixels,
+    bool lightMode,
+    juce::Colour barColor)
+{
+    juce::ignoreUnused(lightMode);
+
+    const float width  = (float)pixels.width;
+    const float height = (float)pixels.height;
+    Render3D::Camera camera { width * 0.5f, height * 0.58f, std::min(width, height) * 0.55f, 4.0f };
+
+    // Spin about the vertical axis, then tilt so the camera looks down on the grid
+    const auto rotation = Render3D::Matrix3::rotationX(0.45f) * Render3D::Matrix3::rotationY(yaw);
+
+    static constexpr float floorY   = 0.5f;
+    static constexpr float spacing  = 2.4f / (float)numBands;
+    static constexpr float rowDepth = 0.3f;
+    const auto& box = Render3D::Mesh::unitBox();
+
+    // Light falls from above and in front, so the bar tops catch it
+    renderer.beginFrame(rotation, camera, { -0.3f, 0.9f, 0.5f }, (size_t)(numRows * numBands) * box.faces.size());
+
+    for (int r = 0; r < numRows; ++r)
+    {
+        // Older rows fade out toward the back
+        const auto rowColour = barColor.withMultipliedAlpha(1.0f - (float)r * 0.09f);
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            const float halfHeight = 0.02f + heights[(size_t)(r * numBands + b)] * 0.55f;
+            const Render3D::Vec3 offset { ((float)b - (numBands - 1) * 0.5f) * spacing,
+                                          floorY - halfHeight,
+                                          ((float)r - (numRows - 1) * 0.5f) * rowDepth };
+
+            renderer.addInstance(box, offset, { spacing * 0.38f, halfHeight, rowDepth * 0.38f }, rowColour);
+        }
+    }
+
+    renderer.render(pixels, {}, 0.0f);
+}
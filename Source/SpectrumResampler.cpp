@@ -0,0 +1,76 @@
+#include "SpectrumResampler.h"
+#include <cmath>
+#include <algorithm>
+
+bool SpectrumResampler::prepare(int numColumns, float minFreq, float maxFreq, double sampleRate, int fftSize)
+{
+    numColumns = std::max(0, numColumns);
+
+    if (numColumns == (int)columns.size() && minFreq == builtMin && maxFreq == builtMax
+     && sampleRate == builtRate && fftSize == builtFftSize)
+        return false;
+
+    builtMin     = minFreq;
+    builtMax     = maxFreq;
+    builtRate    = sampleRate;
+    builtFftSize = fftSize;
+    columns.resize((size_t)numColumns);
+
+    const int    lastBin  = fftSize / 2;
+    const double binWidth = sampleRate / fftSize;
+    const double lo       = std::max(1.0, (double)minFreq);   // log axis: keep clear of DC
+    const double ratio    = std::max(lo, (double)maxFreq) / lo;
+
+    for (int i = 0; i < numColumns; ++i)
+    {
+        // Column i spans [start, end) in Hz
+        const double start = lo * std::pow(ratio, (double)i / numColumns);
+        const double end   = lo * std::pow(ratio, (double)(i + 1) / numColumns);
+
+        const int first = juce::jlimit(0, lastBin, (int)std::ceil(start / binWidth));
+        const int last  = juce::jlimit(0, lastBin, (int)std::ceil(end / binWidth) - 1);
+
+        auto& c = columns[(size_t)i];
+        if (last >= first)
+        {
+            c = { first, last - first + 1, 0.0f };
+        }
+        else
+        {
+            // Too narrow to contain a bin centre: read between bins at the column centre
+            const double position = juce::jlimit(0.0, (double)lastBin, std::sqrt(start * end) / binWidth);
+            const int below = std::min((int)position, lastBin - 1);
+            c = { below, 0, (float)(position - below) };
+        }
+    }
+
+    return true;
+}
+
+void SpectrumResampler::process(const float* magnitudes, float* output) const
+{
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        const auto& c = columns[i];
+        const float* m = magnitudes + c.firstBin;
+
+        if (c.numBins == 0)
+        {
+            output[i] = m[0] + (m[1] - m[0]) * c.fraction;
+        }
+        else if (aggregate == Aggregate::Max)
+        {
+            float peak = m[0];
+            for (int k = 1; k < c.numBins; ++k)
+                peak = std::max(peak, m[k]);
+            output[i] = peak;
+        }
+        else
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < c.numBins; ++k)
+                sum += m[k] * m[k];
+            output[i] = std::sqrt(sum / (float)c.numBins);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Maps FFT magnitude bins onto display columns on a log-frequency axis. A column
+// wider than a bin aggregates every bin whose centre falls inside it (max keeps
+// narrow peaks, RMS keeps energy), so nothing between sample points is lost; a
+// column narrower than a bin interpolates between the two nearest bin centres.
+// The column -> bin table is rebuilt only when the layout changes; keep one per
+// view so that's rare.
+// (implementation in SpectrumResampler.cpp)
+class SpectrumResampler
+{
+public:
+    enum class Aggregate { Max, Rms };
+
+    explicit SpectrumResampler(Aggregate mode = Aggregate::Max) : aggregate(mode) {}
+
+    // Cheap when nothing changed; returns true if the table was rebuilt
+    bool prepare(int numColumns, float minFreq, float maxFreq, double sampleRate, int fftSize);
+
+    // magnitudes: fftSize / 2 + 1 bins (DC .. Nyquist); output: getNumColumns() values
+    void process(const float* magnitudes, float* output) const;
+
+    int getNumColumns() const { return (int)columns.size(); }
+
+private:
+    struct Column
+    {
+        int   firstBin;
+        int   numBins;     // 0 = narrower than a bin: interpolate firstBin .. firstBin + 1
+        float fraction;    // interpolation position when numBins == 0
+    };
+
+    Aggregate aggregate;
+    std::vector<Column> columns;
+
+    float  builtMin = 0.0f, builtMax = 0.0f;
+    double builtRate = 0.0;
+    int    builtFftSize = 0;
+};
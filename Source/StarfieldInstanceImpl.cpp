@@ -1,26 +1,64 @@
 #include "PluginEditor.h"
+#include "SoftwareRaster.h"
 #include <cmath>
 #include <algorithm>
 
+// SplitMix64 over (seed, counter): draw n of a field is the same for a given seed
+float AudioVisualizerEditor::StarfieldInstance::nextRandom()
+{
+    juce::uint64 z = seed + (++counter) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (float)(z >> 40) * (1.0f / 16777216.0f);   // top 24 bits -> [0, 1)
+}
+
+void AudioVisualizerEditor::StarfieldInstance::spawn(size_t i, float z)
+{
+    starX[i] = nextRandom() * 2000.0f - 1000.0f;
+    starY[i] = nextRandom() * 2000.0f - 1000.0f;
+    starZ[i] = z;
+}
+
+int AudioVisualizerEditor::StarfieldInstance::starCountFor(const juce::Rectangle<int>& bounds, float density)
+{
+    const float megapixels = (float)bounds.getWidth() * (float)bounds.getHeight() * 1.0e-6f;
+    const int count = juce::roundToInt(megapixels * starsPerMegapixel * density);
+
+    // Whole batches, so a slowly resizing panel doesn't respawn stars every frame
+    return juce::jlimit(minStars, maxStars, (count + 63) & ~63);
+}
+
 void AudioVisualizerEditor::StarfieldInstance::initStars()
 {
-    stars.clear();
+    const size_t count = starZ.size();
+    counter = 0;
+    starX.clear();
+    starY.clear();
+    starZ.clear();
+    setStarCount((int)count);
+}
 
-    for (int i = 0; i < 200; ++i)
-    {
-        Star star;
-        star.x = random.nextFloat() * 2000.0f - 1000.0f;
-        star.y = random.nextFloat() * 2000.0f - 1000.0f;
-        star.z = random.nextFloat() * 2000.0f + 100.0f;
-        star.prevX = star.x;
-        star.prevY = star.y;
-        star.prevZ = star.z;
-        stars.push_back(star);
-    }
+void AudioVisualizerEditor::StarfieldInstance::setStarCount(int count)
+{
+    const size_t oldCount = starZ.size();
+    const size_t newCount = (size_t)juce::jmax(0, count);
+    if (newCount == oldCount) return;
+
+    starX.resize(newCount);
+    starY.resize(newCount);
+    starZ.resize(newCount);
+
+    // New stars fill the whole depth, as at start-up
+    for (size_t i = oldCount; i < newCount; ++i)
+        spawn(i, nextRandom() * 2000.0f + 100.0f);
 }
 
-void AudioVisualizerEditor::StarfieldInstance::update(float value, bool isBinaryMode)
+void AudioVisualizerEditor::StarfieldInstance::update(float value, bool isBinaryMode, float dt)
 {
+    // Speeds are in units per 60 Hz frame; easing factors likewise
+    const float frames = dt * referenceFrameRate;
+
     // Target speeds - ALWAYS animating
     float baseSpeed = 2.0f;
     float maxSpeed = 80.0f;
@@ -37,12 +75,14 @@ void AudioVisualizerEditor::StarfieldInstance::update(float value, bool isBinary
         if (isActive)
         {
             // Quick attack
-            currentSpeed = currentSpeed * 0.1f + targetSpeed * 0.9f;
+            const float keep = perFrame(0.1f, dt);
+            currentSpeed = currentSpeed * keep + targetSpeed * (1.0f - keep);
         }
         else
         {
             // Ease back, clamped to minimum
-            float newSpeed = currentSpeed * 0.92f + targetSpeed * 0.08f;
+            const float keep = perFrame(0.92f, dt);
+            float newSpeed = currentSpeed * keep + targetSpeed * (1.0f - keep);
             currentSpeed = std::max(newSpeed, baseSpeed);
         }
     }
@@ -56,118 +96,115 @@ void AudioVisualizerEditor::StarfieldInstance::update(float value, bool isBinary
         targetSpeed = juce::jlimit(baseSpeed, maxSpeed, targetSpeed);
 
         // Smooth interpolation towards target
-        currentSpeed = currentSpeed * 0.85f + targetSpeed * 0.15f;
+        const float keep = perFrame(0.85f, dt);
+        currentSpeed = currentSpeed * keep + targetSpeed * (1.0f - keep);
 
         // Ensure never goes below base speed
         currentSpeed = std::max(currentSpeed, baseSpeed);
     }
 
-    // Update star positions
-    for (auto& star : stars)
-    {
-        star.prevX = star.x;
-        star.prevY = star.y;
-        star.prevZ = star.z;
-
-        star.z -= currentSpeed;
-
-        if (star.z < 1.0f)
-        {
-            star.x = random.nextFloat() * 2000.0f - 1000.0f;
-            star.y = random.nextFloat() * 2000.0f - 1000.0f;
-            star.z = 2000.0f;
-            star.prevZ = star.z;
-        }
-    }
+    // Move the field: one contiguous pass over z that vectorises...
+    const float step = currentSpeed * frames;
+    const size_t n = starZ.size();
+    float* z = starZ.data();
+    for (size_t i = 0; i < n; ++i)
+        z[i] -= step;
+
+    // ...then respawn the few that passed the camera
+    for (size_t i = 0; i < n; ++i)
+        if (z[i] < 1.0f)
+            spawn(i, 2000.0f);
 }
 
-void AudioVisualizerEditor::StarfieldInstance::draw(juce::Graphics& g,
+void AudioVisualizerEditor::StarfieldInstance::draw(const juce::Image::BitmapData& pixels,
+                                                     float pixelScale,
                                                      const juce::Rectangle<int>& bounds,
                                                      float centerX,
                                                      float centerY,
                                                      bool lightMode,
                                                      juce::Colour starColor)
 {
-    g.saveState();
-    g.reduceClipRegion(bounds);
+    const SoftwareRaster raster(pixels);
 
-    float scale = 200.0f;
+    // Everything below is in pixels of the panel's bitmap
+    const float s  = pixelScale;
+    const float cx = (centerX - (float)bounds.getX()) * s;
+    const float cy = (centerY - (float)bounds.getY()) * s;
+    const float width  = (float)pixels.width;
+    const float height = (float)pixels.height;
+    const float scale  = 200.0f * s;
+    const float margin = 20.0f * s;
 
     // Show streaks when speed is significantly above base (threshold for visual effect)
-    float baseSpeed = 2.0f;
     float streakThreshold = 15.0f;  // Show streaks when speed > this
     bool showStreaks = currentSpeed > streakThreshold;
+    float speedFactor = juce::jlimit(0.0f, 1.0f, (currentSpeed - streakThreshold) / (80.0f - streakThreshold));
+    float minDistForStreak = width * 0.18f;
+    float maxRadius = width * 0.5f;
+
+    // Configured star color with a subtle gradient toward a darker variant by distance,
+    // resolved into a ramp once per frame rather than per star
+    juce::Colour gradientColor = lightMode ? starColor.darker(0.3f) : starColor.darker(0.4f);
+    std::array<juce::PixelARGB, 32> ramp;
+    SoftwareRaster::buildRamp(ramp, starColor, starColor.interpolatedWith(gradientColor, 0.5f));
+    const auto headColour = starColor.brighter(0.2f).getPixelARGB();
+
+    // Project the whole field in one branch-free pass the compiler can vectorise
+    const size_t n = starZ.size();
+    projectedX.resize(n);
+    projectedY.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const float k = scale / starZ[i];
+        projectedX[i] = cx + starX[i] * k;
+        projectedY[i] = cy + starY[i] * k;
+    }
 
-    for (const auto& star : stars)
+    for (size_t i = 0; i < n; ++i)
     {
-        float screenX = centerX + (star.x / star.z) * scale;
-        float screenY = centerY + (star.y / star.z) * scale;
+        const float screenX = projectedX[i];
+        const float screenY = projectedY[i];
 
-        if (screenX < bounds.getX() - 20 || screenX > bounds.getRight() + 20 ||
-            screenY < bounds.getY() - 20 || screenY > bounds.getBottom() + 20)
+        if (screenX < -margin || screenX > width + margin ||
+            screenY < -margin || screenY > height + margin)
             continue;
 
-        float distFromCenterX = screenX - centerX;
-        float distFromCenterY = screenY - centerY;
+        const float z = starZ[i];
+        float distFromCenterX = screenX - cx;
+        float distFromCenterY = screenY - cy;
         float distFromCenter = std::sqrt(distFromCenterX * distFromCenterX +
                                          distFromCenterY * distFromCenterY);
 
-        // Use configured star color with subtle gradient based on distance
-        float maxRadius = bounds.getWidth() * 0.5f;
         float colorBlend = juce::jlimit(0.0f, 1.0f, distFromCenter / maxRadius);
-
-        // Create a slightly darker/lighter version for gradient effect
-        juce::Colour gradientColor = lightMode ?
-            starColor.darker(0.3f) :
-            starColor.darker(0.4f);
-
-        juce::Colour finalStarColor = starColor.interpolatedWith(gradientColor, colorBlend * 0.5f);
-        g.setColour(finalStarColor);
+        const auto colour = ramp[(size_t)(colorBlend * (float)(ramp.size() - 1))];
 
         if (showStreaks)
         {
-            float minDistForStreak = bounds.getWidth() * 0.18f;
-
             if (distFromCenter > minDistForStreak)
             {
-                float dirX = distFromCenterX;
-                float dirY = distFromCenterY;
-                float length = distFromCenter;
-
-                if (length > 0.001f)
-                {
-                    dirX /= length;
-                    dirY /= length;
-                }
+                float dirX = distFromCenterX / distFromCenter;
+                float dirY = distFromCenterY / distFromCenter;
 
                 // Streak length proportional to speed
-                float speedFactor = juce::jlimit(0.0f, 1.0f, (currentSpeed - streakThreshold) / (80.0f - streakThreshold));
-                float baseStreakLength = juce::jmap(star.z, 1.0f, 2000.0f, 50.0f, 12.0f);
+                float baseStreakLength = juce::jmap(z, 1.0f, 2000.0f, 50.0f, 12.0f) * s;
                 float streakLength = baseStreakLength * (0.3f + speedFactor * 0.7f);
+                float thickness = juce::jmap(z, 1.0f, 2000.0f, 1.5f, 0.6f) * s;
 
-                float startX = screenX - dirX * streakLength;
-                float startY = screenY - dirY * streakLength;
-                float thickness = juce::jmap(star.z, 1.0f, 2000.0f, 1.5f, 0.6f);
+                raster.line(screenX - dirX * streakLength, screenY - dirY * streakLength,
+                            screenX, screenY, thickness, colour);
 
-                juce::Line<float> line(startX, startY, screenX, screenY);
-                g.drawLine(line, thickness);
-
-                g.setColour(starColor.brighter(0.2f));
-                float dotSize = juce::jmap(star.z, 1.0f, 2000.0f, 2.5f, 1.0f);
-                g.fillEllipse(screenX - dotSize * 0.5f, screenY - dotSize * 0.5f, dotSize, dotSize);
+                float dotSize = juce::jmap(z, 1.0f, 2000.0f, 2.5f, 1.0f) * s;
+                raster.dot(screenX, screenY, dotSize, headColour);
             }
             else
             {
-                float size = 1.2f;
-                g.fillEllipse(screenX - size * 0.5f, screenY - size * 0.5f, size, size);
+                raster.dot(screenX, screenY, 1.2f * s, colour);
             }
         }
         else
         {
-            float size = juce::jmap(star.z, 1.0f, 2000.0f, 2.5f, 1.0f);
-            g.fillEllipse(screenX - size * 0.5f, screenY - size * 0.5f, size, size);
+            float size = juce::jmap(z, 1.0f, 2000.0f, 2.5f, 1.0f) * s;
+            raster.dot(screenX, screenY, size, colour);
         }
     }
-
-    g.restoreState();
 }
@@ -0,0 +1,114 @@
+#include "../Source/PluginProcessor.h"
+#include "../Source/PluginEditor.h"
+#include "../Source/AllocationCounter.h"
+
+// Renders each effect type through the panel render job for a run of frames
+// whose inputs only differ in the audio value, then paints the whole editor
+// into an image, and checks that once the buffers have settled none of those
+// frames allocates. The test build always counts allocations
+// (AUDIOVISUALIZER_COUNT_ALLOCATIONS), whatever the configuration.
+//
+// AllocationCounter only sees operator new. juce::Image pixels, HeapBlock and
+// the juce::Array family go through malloc and are invisible to it, so a pass
+// says nothing about those staying flat.
+class FrameAllocationTest : public juce::UnitTest
+{
+public:
+    FrameAllocationTest() : juce::UnitTest("Steady-state frame allocations", "Rendering") {}
+
+    void runTest() override
+    {
+        beginTest("Allocation counting is compiled in");
+        expect(AllocationCounter::isEnabled());
+
+        AudioVisualizerProcessor processor;
+        processor.prepareToPlay(48000.0, 512);
+
+        {
+            AudioVisualizerEditor editor(processor);
+            editor.setSize(800, 600);
+
+            static const char* const names[] = { "Binary Flash", "Flutter", "Starfield",
+                                                 "Spectrum", "3D Cube", "3D Bars" };
+            constexpr int numEffectTypes = (int)EffectType::SpectrumBars3D + 1;
+            static_assert(numEffectTypes == (int)(sizeof(names) / sizeof(names[0])), "one name per effect type");
+
+            for (int t = 0; t < numEffectTypes; ++t)
+            {
+                beginTest(juce::String(names[t]) + " renders steady frames without allocating");
+                expectEquals(steadyFrameAllocations(editor, (EffectType)t), (juce::int64)0);
+            }
+
+            beginTest("Spectrum with the area fill renders steady frames without allocating");
+            editor.panels.front()->config.fillUnderLine = true;
+            expectEquals(steadyFrameAllocations(editor, EffectType::FrequencyLine), (juce::int64)0);
+
+            beginTest("Steady-state paint with the value overlay doesn't allocate");
+            editor.showDebugValues = true;
+            expectEquals(steadyPaintAllocations(editor), (juce::int64)0);
+        }
+
+        processor.releaseResources();
+    }
+
+private:
+    // Past the job's own steadyFramesBeforeCheck, so its assertion is armed too
+    static constexpr int warmUpFrames  = AudioVisualizerEditor::steadyFramesBeforeCheck + 10;
+    static constexpr int checkedFrames = 120;
+
+    static juce::int64 steadyFrameAllocations(AudioVisualizerEditor& editor, EffectType type)
+    {
+        auto& panel = *editor.panels.front();
+        editor.applyEffectToPanel(panel.id, type, juce::Colours::white);
+        panel.paintedKey = editor.panelStateKey(panel);
+
+        // The job runs on this thread, so the counter sees everything it does
+        AudioVisualizerEditor::PanelRenderJob job(editor, panel);
+        auto frame  = editor.capturePanelFrame(panel, 0, 1.0f / 60.0f);
+        frame.scale = 2.0f;
+
+        auto render = [&](int index)
+        {
+            job.frame       = frame;
+            job.frame.value = 0.5f + 0.5f * std::sin((float)index * 0.2f);
+            job.runJob();
+        };
+
+        for (int i = 0; i < warmUpFrames; ++i)
+            render(i);
+
+        const auto before = AllocationCounter::getThreadCount();
+        for (int i = 0; i < checkedFrames; ++i)
+            render(warmUpFrames + i);
+
+        return AllocationCounter::getThreadCount() - before;
+    }
+
+    static juce::int64 steadyPaintAllocations(AudioVisualizerEditor& editor)
+    {
+        // Give every panel a rendered image, so paint() composites them all
+        for (auto& panel : editor.panels)
+        {
+            panel->paintedKey = editor.panelStateKey(*panel);
+            AudioVisualizerEditor::PanelRenderJob job(editor, *panel);
+            job.frame = editor.capturePanelFrame(*panel, 0, 1.0f / 60.0f);
+            job.runJob();
+        }
+
+        // One context for the whole run, as a paint's own context is set up by
+        // the peer before paint() is called
+        juce::Image canvas(juce::Image::RGB, editor.getWidth(), editor.getHeight(), true, juce::SoftwareImageType());
+        juce::Graphics g(canvas);
+
+        for (int i = 0; i < warmUpFrames; ++i)
+            editor.paint(g);
+
+        const auto before = AllocationCounter::getThreadCount();
+        for (int i = 0; i < checkedFrames; ++i)
+            editor.paint(g);
+
+        return AllocationCounter::getThreadCount() - before;
+    }
+};
+
+static FrameAllocationTest frameAllocationTest;
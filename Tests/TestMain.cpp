@@ -0,0 +1,18 @@
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+// Runs every registered juce::UnitTest; a non-zero exit code fails CTest
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runAllTests();
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        if (runner.getResult(i)->failures > 0)
+            return 1;
+
+    return 0;
+}